@@ -0,0 +1,118 @@
+#pragma once
+#include <coroutine>
+#include <cstddef>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+#include "Simulation.h"
+
+// Passenger behaviour as C++20 coroutine scripts over the headless simulation.
+// A script reads as the agent's day - walk to the hall, call, wait, board, ride,
+// alight, walk to the desk, come back later - and every co_await suspends it
+// until the event it names: a timer, its passenger boarding, or arriving. The
+// world resumes agents from the simulation's event lists and a timer heap, so
+// a suspended agent costs nothing per step, only its coroutine frame. Frames
+// come from a size-class pool and go back to it when a script ends.
+// Single-threaded: one world, one pool, the simulation's thread.
+
+const size_t AGENT_FRAME_CLASS = 64;            // Pool size classes are multiples of this
+const int AGENT_FRAME_CLASSES = 16;             // Larger frames use the global heap
+
+struct AgentFramePool {
+    std::vector<void*> freeFrames[AGENT_FRAME_CLASSES];
+    long long allocated;        // Frames taken from the heap
+    long long reused;           // Frames handed out again from a free list
+    long long live;
+    long long peakLive;
+    size_t liveBytes;
+};
+
+AgentFramePool& agentFramePool();
+
+struct AgentWorld;
+
+struct AgentTask {
+    struct promise_type {
+        AgentWorld* world = nullptr;
+
+        static void* operator new(size_t size);
+        static void operator delete(void* frame, size_t size);
+
+        AgentTask get_return_object() { return {std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }     // The frame frees itself when the script ends
+        void return_void();
+        void unhandled_exception();
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+struct AgentTimer {
+    double time;
+    long long order;            // Ties wake in the order they slept
+    std::coroutine_handle<> agent;
+    bool operator>(const AgentTimer& other) const { return time != other.time ? time > other.time : order > other.order; }
+};
+
+struct AgentWorld {
+    Simulation sim;
+    std::priority_queue<AgentTimer, std::vector<AgentTimer>, std::greater<AgentTimer>> timers;
+    long long timerOrder;
+    std::unordered_map<int, std::coroutine_handle<>> boardWaiters;      // Passenger id -> agent
+    std::unordered_map<int, std::coroutine_handle<>> arrivalWaiters;
+    int started;
+    int finished;
+    int peakSuspended;
+};
+
+// Awaitables - co_await them from a script
+struct SleepAwaiter {
+    AgentWorld& world;
+    double wakeTime;            // On the simulation's double clock
+    bool await_ready() const { return wakeTime <= world.sim.time; }
+    void await_suspend(std::coroutine_handle<> agent);
+    void await_resume() const {}
+};
+
+// Registers the trip and resumes once the passenger is in a car; yields the passenger id,
+// or -1 right away when no zone serves the trip
+struct CallAwaiter {
+    AgentWorld& world;
+    int origin;
+    int destination;
+    int passenger;
+    bool await_ready() const { return false; }
+    bool await_suspend(std::coroutine_handle<> agent);
+    int await_resume() const { return passenger; }
+};
+
+// Resumes once the passenger has reached the trip's destination
+struct ArrivalAwaiter {
+    AgentWorld& world;
+    int passenger;
+    bool await_ready() const { return passenger < 0 || world.sim.passengers[passenger].delivered; }
+    void await_suspend(std::coroutine_handle<> agent);
+    void await_resume() const {}
+};
+
+SleepAwaiter sleepFor(AgentWorld& world, float seconds);
+SleepAwaiter sleepUntil(AgentWorld& world, double time);
+CallAwaiter callElevator(AgentWorld& world, int origin, int destination);
+ArrivalAwaiter rideUntilArrived(AgentWorld& world, int passenger);
+
+void initAgentWorld(AgentWorld& world, const SimConfig& config);
+// Runs the script up to its first suspension
+void startAgent(AgentWorld& world, AgentTask task);
+// Steps the simulation, then resumes the agents its events and the clock have woken
+void stepAgentWorld(AgentWorld& world, float deltaTime);
+int suspendedAgents(const AgentWorld& world);
+// Destroys every suspended script, returning the frames to the pool
+void shutdownAgentWorld(AgentWorld& world);
+
+// An office worker: arrives in the morning, rides to the desk floor, goes down for lunch and back, leaves
+AgentTask officeWorker(AgentWorld& world, int deskFloor, float arrival, float lunch, float leave);
+
+// Simulates an office day of numAgents workers, then parks numParked sleeping agents to
+// measure what a suspended agent costs
+void runAgentDay(int numAgents, int numParked);
@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+
+// Minimum-cost assignment of hall calls to cars, each car taking up to numSlots calls.
+// The k-th call a car takes costs its base cost plus k * slotCost, the extra wait of
+// the stops planned ahead of it. Solved as an assignment problem over (car, slot)
+// columns with the Hungarian method in shortest augmenting path form: calls are
+// added one at a time and each addition is a single augmentation that keeps the
+// calls already placed optimal, so new calls can be planned incrementally between
+// full re-solves. All slots of a car share one path label, so a search step costs
+// O(cars) rather than O(cars * slots).
+
+// Base cost of a pair that must not be used - calls left on such a pair count as unassigned
+const float ASSIGNMENT_INFEASIBLE = 1e6f;
+
+struct AssignmentSolver {
+    int numCars;
+    int numSlots;
+    float slotCost;
+    int numCalls;
+    std::vector<float> cost;            // Base cost [call * numCars + car]
+    std::vector<int> callColumn;        // Column (car * numSlots + slot) of each call
+    std::vector<int> columnCall;        // 1-based call per 1-based column, [0] is the augmenting root
+
+    // Dual potentials and search state, kept between additions
+    std::vector<double> callPotential;
+    std::vector<double> columnPotential;
+    std::vector<double> columnDist;
+    std::vector<int> way;
+    std::vector<char> columnDone;
+    std::vector<int> doneColumns;
+    std::vector<double> carDist;        // Shortest path label shared by the car's open slots
+    std::vector<int> carWay;
+    std::vector<double> carOffset;      // Smallest slot cost minus potential over the car's open slots
+    std::vector<int> carSlot;
+};
+
+void resetAssignment(AssignmentSolver& solver, int numCars, int numSlots, float slotCost);
+// Appends a call with one base cost per car and re-optimises. Returns false when every slot is taken.
+bool addAssignmentCall(AssignmentSolver& solver, const float* carCosts);
+// Full solve, replacing whatever the solver held
+void solveAssignment(AssignmentSolver& solver, int numCalls, const float* costs);
+// Car serving the call, -1 if the only car it could get is infeasible
+int assignedCar(const AssignmentSolver& solver, int call);
+float totalAssignmentCost(const AssignmentSolver& solver);
+
+// Times full solves and incremental additions on random car/call layouts and
+// compares the result with greedy per-call assignment
+void benchmarkAssignment(int numCars, int numCalls, int runs);
@@ -0,0 +1,41 @@
+#pragma once
+#include "Util.h"
+#include "Elevator.h"
+
+// Floor dimensions in 3D world (FLOOR_HEIGHT and NUM_FLOORS live in Elevator.h)
+const float FLOOR_WIDTH = 20.0f;      // Width of the building
+const float FLOOR_DEPTH = 16.0f;      // Depth of each floor
+const float ELEVATOR_SIZE = 3.9f;     // Elevator cabin size
+
+// Elevator position - in back-right corner
+const float ELEVATOR_X = FLOOR_WIDTH/2 - ELEVATOR_SIZE/2;   // Right side
+const float ELEVATOR_Z = -FLOOR_DEPTH/2 + ELEVATOR_SIZE/2;  // Back side
+
+// The building's floors, walls and ceilings and the cabin shell, transformed
+// once at load into one interleaved vertex buffer (position, tex coords,
+// normal - the layout of the unit quads in Util) with one index buffer. Each
+// surface group sharing a texture is a range of indices, so drawing it is a
+// single glDrawElements with no model matrix to build. Floors are baked in
+// world space; the cabin is baked standing at y = 0 and drawn translated to
+// the car's height.
+
+struct DrawRange {
+    int first;          // First index in the element buffer
+    int count;
+    Vec3 center;        // For depth sorting
+};
+
+struct BuildingGeometry {
+    unsigned int VAO, VBO, EBO;
+    DrawRange floors[NUM_FLOORS];       // pod.png
+    DrawRange ceilings[NUM_FLOORS];     // plafon.jpg
+    DrawRange walls[NUM_FLOORS];        // The floor's own wall texture
+    DrawRange cabinExterior;            // Metal top and three walls, normals outward
+    DrawRange cabinExteriorDoor;
+    DrawRange cabinInterior;            // Metal ceiling and three walls, normals inward
+    DrawRange cabinInteriorDoor;
+    DrawRange cabinFloor;
+};
+
+BuildingGeometry createBuildingGeometry();
+void deleteBuildingGeometry(BuildingGeometry& building);
@@ -0,0 +1,101 @@
+#pragma once
+#include <vector>
+
+// Building layout shared by the 3D scene and the headless simulation
+const float FLOOR_HEIGHT = 6.0f;      // Height of each floor
+const int NUM_FLOORS = 8;
+
+// Default door dwell in seconds - the "open" button extends it once per opening
+const float DOOR_OPEN_TIME = 5.0f;
+const float DOOR_EXTENDED_TIME = 10.0f;
+
+// Rated load of a standard 8 person / 630 kg cabin
+const int ELEVATOR_CAPACITY_PERSONS = 8;
+const float ELEVATOR_CAPACITY_KG = 630.0f;
+const float PASSENGER_WEIGHT_KG = 75.0f;
+
+// Above this load factor a car stops answering new hall calls
+const float HALL_CALL_BYPASS_LOAD = 0.8f;
+
+// Drive energy of a traction car. The counterweight balances the empty car plus
+// COUNTERWEIGHT_BALANCE of the rated load, so the motor lifts only the imbalance:
+// a full car going down or an empty car going up drives the machine as a
+// generator and part of that energy is fed back. Every run also accelerates car,
+// load and counterweight, and gets some of that back when braking - a short run
+// only reaches the speed RATED_ACCELERATION allows over half its length.
+const float GRAVITY = 9.81f;
+const float RATED_ACCELERATION = 1.0f;        // m/s^2
+const float CAR_MASS_PER_RATED_KG = 1.4f;     // Empty cabin mass per kg of rated load
+const float COUNTERWEIGHT_BALANCE = 0.45f;
+const float DRIVE_EFFICIENCY = 0.75f;
+const float REGEN_EFFICIENCY = 0.65f;
+const float STANDBY_POWER_W = 150.0f;         // Controller, lighting and ventilation
+const float DOOR_CYCLE_ENERGY_J = 1500.0f;
+
+// A double-deck car carries a second cabin one floor above the first. It stops
+// at floor pairs (even floor below, odd floor above), so y, currentFloor and the
+// queued floors always refer to the lower cabin.
+const int MAX_DECKS = 2;
+
+struct Elevator {
+    float y;                    // Current Y position (world coords)
+    int currentFloor;
+    int targetFloor;
+    bool moving;
+    bool doorsOpen;
+    float doorTimer;
+    float speed;
+    bool doorExtendUsed;
+    std::vector<int> queuedFloors;
+
+    int decks = 1;
+    float doorOpenTime = DOOR_OPEN_TIME;
+    float doorExtendedTime = DOOR_EXTENDED_TIME;
+
+    // Load weighing - capacity is per cabin, counts are for the whole car
+    int capacityPersons = ELEVATOR_CAPACITY_PERSONS;
+    float capacityKg = ELEVATOR_CAPACITY_KG;
+    int passengerCount = 0;
+    float loadKg = 0.0f;
+    int deckPassengers[MAX_DECKS] = {0, 0};
+    float deckLoadKg[MAX_DECKS] = {0.0f, 0.0f};
+
+    // Accumulated by stepElevator
+    double energyUsedJ = 0.0;
+    double energyRecoveredJ = 0.0;
+    float runSpeed = 0.0f;      // Peak speed of the current run
+};
+
+float getFloorYPosition(int floor);
+
+// Floor the lower cabin stops at so that one of the car's cabins serves "floor"
+int stopFloorFor(const Elevator& elevator, int floor);
+// Cabin (0 = lower) that serves "floor" when the car is at its stop
+int deckFor(const Elevator& elevator, int floor);
+// True when the car is standing with one of its cabins at "floor"
+bool isAtStopFor(const Elevator& elevator, int floor);
+
+// Car call from the cabin panel - always accepted
+void addFloorToQueue(Elevator& elevator, int floor);
+// Hall call from a landing - returns false if the car is too full to answer it
+bool addHallCall(Elevator& elevator, int floor);
+
+// Sets the car off for "floor" - the next queued stop, a parking trip or a new
+// target on the way. Every run starts here so runSpeed and the start energy
+// stay in step with the move.
+void startRun(Elevator& elevator, int floor);
+// Advances doors and motion, returns true on the step the car arrives at a floor
+bool stepElevator(Elevator& elevator, float deltaTime);
+
+float emptyCarKg(const Elevator& elevator);
+float counterweightKg(const Elevator& elevator);
+// Net drive energy in joules of one run from fromY to toY carrying loadKg, with
+// start, stop and door cycle - negative when regeneration outweighs
+float runEnergy(const Elevator& elevator, float fromY, float toY, float loadKg);
+
+// Fraction of rated load in use in the fullest cabin (whichever of persons/kg is closer to the limit)
+float getLoadFactor(const Elevator& elevator);
+bool isBypassingHallCalls(const Elevator& elevator);
+// Returns false (boarding refused) if the passenger would overload the cabin
+bool boardElevator(Elevator& elevator, float weightKg, int deck = 0);
+void alightElevator(Elevator& elevator, float weightKg, int deck = 0);
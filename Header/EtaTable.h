@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include "Elevator.h"
+
+// Predicted arrival of one car at every floor, kept up to date incrementally.
+// A car serves its queue in order, so it stops at a queued floor on the way and
+// reaches any other floor only after its last stop. The table stores the
+// absolute arrival time of each stop on the route; those stay valid while the
+// car follows its plan, so a query is O(1). syncEtaTable compares the car with
+// the cached route and touches only what changed:
+//   - a stop appended to the queue computes one entry
+//   - arriving at a stop drops it from the front
+//   - a door extension or a hold shifts every entry through one offset
+//   - a reordered queue or a new target (direction change) recomputes from the
+//     first stop that differs
+//   - a new cruise speed (energy-saving mode) recomputes the whole route
+// An arrival slightly off its prediction moves the offset by the difference; one
+// further off than ETA_DRIFT_TOLERANCE rebuilds the table from the car's state.
+
+const float ETA_DRIFT_TOLERANCE = 1.0f;     // Seconds an arrival may miss its prediction by
+const int ETA_COMPACT_STOPS = 32;           // Passed stops kept before the route is shifted down
+
+struct EtaTable {
+    std::vector<int> route;             // Stop floors in the order the car makes them, from head
+    std::vector<float> arrival;         // Predicted arrival per stop, before the offset
+    std::vector<float> dwellBefore;     // Door time spent before reaching the stop, before the offset
+    std::vector<int> floorStop;         // Route index of the first stop at each floor, -1 if none
+    int head;
+    float freeTime;                     // When the car has finished its route, and where
+    float freeY;
+    float freeDwell;
+    float offset;                       // Door extensions and holds since the entries were computed
+    float dwellDone;                    // Door time already behind the car
+
+    // Car state at the last sync
+    float syncTime;
+    float speed;
+    bool moving;
+    bool doorsOpen;
+    bool doorExtendUsed;
+
+    long long entriesComputed;
+};
+
+struct Eta {
+    float travel;       // Seconds moving before the car stops at the floor
+    float dwell;        // Seconds of door time at the stops before it
+};
+
+void initEtaTable(EtaTable& table, const Elevator& car, int numFloors, float now);
+// Brings the table in line with the car after it stepped or its queue changed
+void syncEtaTable(EtaTable& table, const Elevator& car, float now);
+// Time until the car can stop at "floor" (a stop floor of the car), the table must be synced
+Eta estimateArrival(const EtaTable& table, const Elevator& car, int floor, float now);
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Elevator.h"
+
+// Kinematic and door state of many cars in structure-of-arrays form, stepped
+// FLEET_BATCH cars at a time with SSE. The per-car branches of stepElevator
+// (doors open -> tick timer, moving -> advance, close enough -> arrive) become
+// lane masks; only the rare events - a car leaving for its next queued stop or
+// arriving - drop to scalar code for the lanes concerned.
+// Load, energy and the door extension button stay with the per-car Elevator;
+// a fleet carries what portfolio-scale runs step on every frame.
+
+const int FLEET_BATCH = 4;
+const int FLEET_ALIGNMENT = 16;
+
+struct Fleet {
+    int count;
+    int lanes;                      // count rounded up to FLEET_BATCH, spare lanes stay idle
+
+    // Lane arrays, FLEET_ALIGNMENT aligned
+    float* y;
+    float* targetY;
+    float* speed;
+    float* doorTimer;
+    float* doorDwell;               // Dwell of the current opening
+    float* doorOpenTime;
+    std::uint32_t* moving;          // Masks - all bits set when true
+    std::uint32_t* doorsOpen;
+    std::uint32_t* pending;         // Queue not empty
+
+    std::vector<int> currentFloor;
+    std::vector<int> targetFloor;
+    std::vector<std::vector<int>> queues;
+    long long arrivals;
+
+    std::vector<float> floatStorage;
+    std::vector<std::uint32_t> maskStorage;
+};
+
+void initFleet(Fleet& fleet, int count);
+void loadFleet(Fleet& fleet, const std::vector<Elevator>& cars);
+// Copies position, floors, doors and queues back into the cars
+void storeFleet(const Fleet& fleet, std::vector<Elevator>& cars);
+
+// Same rules as addFloorToQueue
+void addFleetStop(Fleet& fleet, int car, int floor);
+
+void stepFleet(Fleet& fleet, float deltaTime);
+// Lane-by-lane reference for stepFleet, also used where SSE is unavailable
+void stepFleetScalar(Fleet& fleet, float deltaTime);
+
+// Car-steps per second of the SSE and scalar fleet and of stepElevator on random traffic
+void benchmarkFleet(int numCars, int steps);
@@ -0,0 +1,50 @@
+#pragma once
+#include <GL/glew.h>
+
+// Shadow copy of the GL state the renderer changes most: bound program,
+// vertex array, 2D texture and 2D texture array per unit and the
+// blend/depth/cull switches.
+// Every setter compares with the copy first and only calls into GL when the
+// value really changes, counting both the calls it made and the ones it
+// skipped. Code that binds objects directly (resource loading) must call
+// resetGLState afterwards so the copy does not go stale.
+
+const int GL_STATE_TEXTURE_UNITS = 8;
+
+enum GLStateKind {
+    GL_STATE_PROGRAM,
+    GL_STATE_VERTEX_ARRAY,
+    GL_STATE_ACTIVE_TEXTURE,
+    GL_STATE_TEXTURE,
+    GL_STATE_BLEND,
+    GL_STATE_DEPTH_TEST,
+    GL_STATE_CULL_FACE,
+    GL_STATE_KINDS
+};
+
+struct GLStateCache {
+    // ~0u / -1 mean unknown, so the next set always reaches GL
+    unsigned int program;
+    unsigned int vertexArray;
+    unsigned int activeTexture;
+    unsigned int textures[GL_STATE_TEXTURE_UNITS];
+    unsigned int textureArrays[GL_STATE_TEXTURE_UNITS];
+    int blend;
+    int depthTest;
+    int cullFace;
+    long long issued[GL_STATE_KINDS];
+    long long skipped[GL_STATE_KINDS];
+};
+
+extern GLStateCache glState;
+
+// Forgets the shadow copy, keeps the counters
+void resetGLState();
+void useProgram(unsigned int program);
+void bindVertexArray(unsigned int vertexArray);
+void bindTexture2D(unsigned int unit, unsigned int texture);
+void bindTextureArray(unsigned int unit, unsigned int texture);
+void setBlend(bool enabled);
+void setDepthTest(bool enabled);
+void setCullFace(bool enabled);
+void printGLStateStats(long long frames);
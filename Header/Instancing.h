@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+#include "Util.h"
+
+// Instanced drawing of repeated meshes. The instance buffer holds one
+// InstanceData per copy; Shaders/3d_instanced.vert reads it through vertex
+// attributes 3-8 (advanced once per instance), so a whole batch goes out in a
+// single glDraw*Instanced. Batches sample a 2D texture array and the material
+// index is the instance's layer - one layer per button face or plant type.
+
+const int INSTANCE_ATTRIBUTE_MODEL = 3;     // Four vec4 columns, locations 3-6
+const int INSTANCE_ATTRIBUTE_AMBIENT = 7;
+const int INSTANCE_ATTRIBUTE_MATERIAL = 8;
+
+struct InstanceData {
+    float model[16];
+    float ambient;
+    int material;                   // Layer of the batch's texture array
+};
+
+struct InstanceBatch {
+    unsigned int vertexArray;       // The mesh's VAO with the instance attributes attached
+    unsigned int buffer;
+    int capacity;                   // Instances the buffer has room for
+    bool indexed;                   // glDrawElementsInstanced, otherwise glDrawArraysInstanced
+    int count;                      // Indices or vertices of one instance
+    std::vector<InstanceData> instances;
+};
+
+// Attaches an instance buffer to an existing mesh VAO
+void createInstanceBatch(InstanceBatch& batch, unsigned int vertexArray, int count, bool indexed);
+void deleteInstanceBatch(InstanceBatch& batch);
+void addInstance(InstanceBatch& batch, const Mat4& model, float ambient, int material = 0);
+// Copies batch.instances into the instance buffer
+void uploadInstances(InstanceBatch& batch);
+// Uploads the instances and draws them with one call; the program must be bound
+void drawInstanceBatch(InstanceBatch& batch);
+
+// Scales every texture to size x size with framebuffer blits into layer i of a
+// GL_TEXTURE_2D_ARRAY, so textures of any size share one binding. Layers of
+// textures that failed to load (0) stay transparent.
+unsigned int createTextureArray(const std::vector<unsigned int>& textures, int size);
@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include "Simulation.h"
+
+// Tunes the per-pattern dispatch weights with a genetic algorithm. A candidate
+// is the stop and load weight of every traffic pattern (travelWeight stays 1,
+// it only sets the unit of the cost). Each candidate runs every scenario of the
+// suite headless with several traffic seeds, and its score is the mean over
+// those runs of its waits relative to the hand-tuned weights' waits on the same
+// run, so 1.0 matches dispatchParamsFor and lower is better. A generation's runs
+// are spread over a ThreadPool.
+
+const char* const DISPATCH_WEIGHTS_FILE = "dispatch_weights.txt";
+const int OPTIMIZER_GENES = 2 * TRAFFIC_MODE_COUNT;
+const float OPTIMIZER_WEIGHT_MAX = 4.0f;
+const float OPTIMIZER_MAX_WAIT_SHARE = 0.2f;    // Part of the score from the longest wait, so no floor is starved
+
+struct OptimizerSpec {
+    int generations;
+    int population;
+    int eliteCount;             // Best candidates carried over unchanged
+    int tournamentSize;
+    float mutationRate;         // Chance per gene
+    float mutationSigma;        // Share of OPTIMIZER_WEIGHT_MAX
+    float duration;             // Simulated seconds per scenario run
+    float timeStep;             // Seconds per simulation step, the window's frame time by default
+    int seedsPerScenario;       // Traffic seeds each candidate is averaged over
+    int threads;                // 0 uses every core
+    unsigned int seed;
+};
+
+OptimizerSpec defaultOptimizerSpec();
+// Up-peak, heavy, down-peak and interfloor traffic in the 3D building, plus a zoned tower
+std::vector<SimConfig> optimizerScenarios();
+
+// Writes the best weights to outputPath after every generation and leaves them in "best"
+void optimizeDispatchWeights(const OptimizerSpec& spec, const char* outputPath, DispatchParams best[TRAFFIC_MODE_COUNT]);
+
+// One line per traffic pattern: name, travel, stop and load weight, return-to-lobby flag
+bool saveDispatchWeights(const char* path, const DispatchParams weights[TRAFFIC_MODE_COUNT]);
+// Patterns missing from the file keep their current weights. Returns false if
+// the file cannot be read or holds no valid line.
+bool loadDispatchWeights(const char* path, DispatchParams weights[TRAFFIC_MODE_COUNT]);
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Util.h"
+#include "Shader.h"
+#include "Building.h"
+#include "Instancing.h"
+
+// Draws of the 3D scene are not issued where the scene code describes them:
+// they are collected as packets and submitted sorted by a 64-bit key, so draws
+// sharing a program, texture and vertex array end up next to each other and
+// the GL state cache skips the rebinds between them.
+//
+// Opaque key:      pass:1 | light:2 | program:8 | texture:11 | vertexArray:10 | depth:32
+// Transparent key: pass:1 | ~depth:31 | light:2 | program:8 | texture:12 | vertexArray:10
+//
+// Opaque draws go front to back within a state group so the depth test rejects
+// hidden fragments early; transparent ones go back to front over all states,
+// which blending needs. GL names wider than their field are masked - that can
+// only split a group, the packet still binds its own objects.
+
+enum RenderPass {
+    RENDER_OPAQUE = 0,          // Drawn first, blending off
+    RENDER_TRANSPARENT = 1      // Drawn last, blending on
+};
+
+struct DrawPacket {
+    uint64_t key;
+    const ShaderProgram* program;
+    unsigned int vertexArray;
+    unsigned int texture;       // 2D texture, or a texture array for batches and layered draws
+    int layer;                  // Layer of the texture array, -1 if texture is a 2D texture
+    int first;                  // First index, or first vertex for glDrawArrays
+    int count;
+    bool indexed;               // glDrawElements of "count" indices, otherwise glDrawArrays
+    int light;                  // Light pass of the frame uniforms
+    InstanceBatch* batch;       // Instanced draw of the whole batch, ambient and model unused
+    int indirectSlot;           // Command of the frame's indirect buffer, -1 if drawn directly
+    float ambient;
+    Mat4 model;
+};
+
+// Layout glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+struct IndirectCommand {
+    uint32_t count;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t baseVertex;
+    uint32_t baseInstance;      // Index of the draw's record in the per-draw buffer
+};
+
+struct RenderQueue {
+    std::vector<DrawPacket> packets;
+    Vec3 eye;
+    int light;
+
+    // Multi-draw indirect path, off unless enableIndirectDraws succeeds
+    bool indirect = false;
+    const ShaderProgram* indirectProgram = NULL;
+    InstanceBatch* perDraw = NULL;
+    unsigned int commandBuffer = 0;
+    int commandCapacity = 0;
+    std::vector<IndirectCommand> commands;
+    long long indirectCalls = 0;
+    long long indirectDraws = 0;
+};
+
+void beginRenderQueue(RenderQueue& queue, const Vec3& eye);
+// Sends the opaque indexed draws of perDraw's vertex array through
+// glMultiDrawElementsIndirect: one command per draw in a buffer filled once per
+// frame and one call per run of draws sharing texture and light pass. A draw's
+// model matrix, ambient and layer go into perDraw's instance buffer at the
+// index the command passes as its base instance, where the instanced vertex
+// shader fetches them. Only layered draws qualify, as the program samples the
+// texture array. Needs GL 4.3 or ARB_multi_draw_indirect with ARB_base_instance;
+// returns false (and the queue keeps drawing one call per packet) otherwise.
+bool enableIndirectDraws(RenderQueue& queue, const ShaderProgram& program, InstanceBatch& perDraw);
+void deleteRenderQueue(RenderQueue& queue);
+// Light pass used by the draws submitted after this call
+void setQueueLight(RenderQueue& queue, int light);
+void submitDraw(RenderQueue& queue, RenderPass pass, const ShaderProgram& program, unsigned int vertexArray,
+                unsigned int texture, int count, bool indexed, float ambient, const Mat4& model);
+// Draws a baked range of an indexed vertex array, sorted by its center. With a
+// layer >= 0 texture is a texture array and the program gets the layer in uLayer.
+void submitRange(RenderQueue& queue, RenderPass pass, const ShaderProgram& program, unsigned int vertexArray,
+                 unsigned int texture, int layer, const DrawRange& range, float ambient, const Mat4& model);
+// Draws every instance of the batch at once, sorted by the first instance;
+// texture is the array the instances' materials index
+void submitInstances(RenderQueue& queue, RenderPass pass, const ShaderProgram& program, InstanceBatch& batch,
+                     unsigned int texture);
+// Sorts the packets, draws them and empties the queue
+void flushRenderQueue(RenderQueue& queue, const FrameUniforms& frame);
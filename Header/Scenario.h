@@ -0,0 +1,65 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Elevator.h"
+#include "Simulation.h"
+
+// Declarative scenario: the building, its cars and zones, the traffic profile and
+// seed, the 3D scene's textures, button panel and starting positions, and
+// optionally a pre-recorded list of trips. The file is plain text, one setting
+// per line, '#' starts a comment:
+//
+//   floors 8
+//   cars 2                          # One bank serving every floor, unless zones are given
+//   zone 0 20 1 4                   # lowest highest lobby cars - one line per zone
+//   decks 1
+//   cars_per_shaft 1
+//   speed 3                         # m/s
+//   capacity 8 630                  # persons kg, per cabin
+//   doors 5 10                      # open and extended dwell, seconds
+//   traffic 12 1 0.8 0.5            # arrivals/min, lobby, lobby origin share, lobby destination share
+//   parking predicted               # none | predicted
+//   assignment greedy               # greedy | batch
+//   adaptive on
+//   energy_saving off
+//   start 8:00
+//   seed 12345
+//   duration 60                     # minutes run by --run-scenario
+//   car_floor 2                     # 3D scene only from here on
+//   person_floor 1
+//   floor_texture 0 Resources/podrum.jpg
+//   button 0 0 7 Resources/taster6.png    # column row (floor | open | close | stop | fan) texture
+//   trips 1000000                   # every line after this is a trip, the count only reserves
+//   0.0 1 5                         # seconds origin destination [kg], kg at most the capacity
+//
+// The file is read in fixed chunks and parsed line by line straight into the
+// Scenario - nothing is tokenised ahead or kept as a tree, so trip lists of
+// millions of rows load at about the speed the disk delivers them.
+
+const size_t SCENARIO_CHUNK_BYTES = 1 << 20;    // Also the longest line accepted
+
+struct ScenarioButton {
+    int column;             // 0 = left, 1 = right
+    int row;                // Counted from the top
+    int action;             // Floor, or -1 open, -2 close, -3 stop, -4 ventilation (as Button3D::floorNumber)
+    std::string texture;
+};
+
+struct Scenario {
+    SimConfig config;
+    float duration;
+    std::string floorTextures[NUM_FLOORS];
+    std::vector<ScenarioButton> buttons;    // In panel order
+    int carStartFloor;
+    int personStartFloor;
+    std::vector<ScheduledTrip> trips;       // Sorted by time
+    size_t bytesRead;
+};
+
+// The building main() used to set up by hand
+Scenario defaultScenario();
+// Overrides whatever the file sets, zones and buttons are replaced as a whole.
+// Prints the offending line and returns false on a malformed file.
+bool loadScenario(const char* path, Scenario& scenario);
+// Simulates the scenario headless, its trips are moved into the simulation
+SimStats runScenario(Scenario& scenario, float deltaTime);
@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Util.h"
+
+// Shader program with its uniform locations reflected once at link time.
+// Uniforms are addressed by the FNV-1a hash of their name, computed by the
+// compiler for the U_* handles below, so setting one is a probe into a small
+// open-addressing table instead of a glGetUniformLocation string lookup.
+// Two uniforms of one program whose names hash alike abort at link time.
+// Arrays are registered under their base name, so element 0's location
+// uploads the whole array.
+
+typedef uint32_t UniformHandle;
+
+constexpr UniformHandle uniformHash(const char* name)
+{
+    uint32_t hash = 2166136261u;
+    for (; *name; name++) hash = (hash ^ (uint8_t)*name) * 16777619u;
+    return hash ? hash : 1;     // 0 marks an empty slot
+}
+
+constexpr UniformHandle U_MODEL = uniformHash("uModel");
+constexpr UniformHandle U_AMBIENT_STRENGTH = uniformHash("uAmbientStrength");
+constexpr UniformHandle U_ALPHA = uniformHash("uAlpha");
+constexpr UniformHandle U_COLOR = uniformHash("uColor");
+constexpr UniformHandle U_LAYER = uniformHash("uLayer");
+
+struct UniformSlot {
+    UniformHandle hash;
+    int location;
+};
+
+struct ShaderProgram {
+    unsigned int id;
+    unsigned int mask;                  // Table size - 1, the size is a power of two
+    std::vector<UniformSlot> slots;
+};
+
+ShaderProgram createShaderProgram(const char* vsSource, const char* fsSource);
+void deleteShaderProgram(ShaderProgram& program);
+// -1 (ignored by glUniform*) if the program has no such active uniform
+int uniformLocation(const ShaderProgram& program, UniformHandle uniform);
+
+void setShaderMat4(const ShaderProgram& program, UniformHandle uniform, const Mat4& mat);
+void setShaderVec3(const ShaderProgram& program, UniformHandle uniform, const Vec3& vec);
+void setShaderVec4(const ShaderProgram& program, UniformHandle uniform, float x, float y, float z, float w);
+void setShaderFloat(const ShaderProgram& program, UniformHandle uniform, float value);
+void setShaderInt(const ShaderProgram& program, UniformHandle uniform, int value);
+
+// Camera and light constants shared by the 3D programs through two std140
+// uniform blocks backed by one buffer. The camera block and every light pass
+// of the frame are staged on the CPU and go up in one upload per frame; a
+// pass switch is then a glBindBufferRange, so per-draw uploads are down to
+// the model matrix (plus uAmbientStrength where a draw glows).
+const unsigned int FRAME_BLOCK_BINDING = 0;
+const unsigned int LIGHT_BLOCK_BINDING = 1;
+const unsigned int BUTTON_LIGHT_BLOCK_BINDING = 2;
+const int MAX_LIGHT_PASSES = 4;
+
+struct FrameBlock {                     // uniform Frame
+    float view[16];
+    float projection[16];
+    float viewPos[3];
+    float padding;
+    float panelOrigin[3];               // Button panel of the person's cabin, see ButtonLightBlock
+    float padding2;
+};
+
+struct LightBlock {                     // uniform Light
+    float lightPos[3];
+    float constant;
+    float lightColor[3];
+    float linear;
+    float quadratic;
+    float padding[3];
+};
+
+struct FrameUniforms {
+    unsigned int buffer;
+    int lightOffset;                    // Offset of the first light pass
+    int lightStride;                    // LightBlock rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    int lights;
+    std::vector<unsigned char> staging;
+};
+
+void createFrameUniforms(FrameUniforms& frame);
+void deleteFrameUniforms(FrameUniforms& frame);
+// Points the program's Frame and Light blocks at their binding points
+void bindFrameBlocks(const ShaderProgram& program);
+// Starts a new frame - drops the light passes of the previous one
+void setFrameCamera(FrameUniforms& frame, const Mat4& view, const Mat4& projection, const Vec3& viewPos);
+void setFramePanelOrigin(FrameUniforms& frame, const Vec3& origin);
+// Returns the pass index for useFrameLight
+int addFrameLight(FrameUniforms& frame, const Vec3& lightPos, const Vec3& lightColor, float constant, float linear, float quadratic);
+void uploadFrameUniforms(const FrameUniforms& frame);
+void useFrameLight(const FrameUniforms& frame, int light);
+
+// Glow of the lit call buttons. Positions are relative to the panel origin in
+// the Frame block, so the packed array only changes when a button is pressed
+// or cleared (or the person steps in or out of the cabin), not as the car
+// moves - updateButtonLights skips the upload when nothing differs.
+const int MAX_BUTTON_LIGHTS = 12;       // Size of the array in Shaders/3d.frag
+
+struct ButtonLightBlock {               // uniform ButtonLights
+    float lights[MAX_BUTTON_LIGHTS][4]; // xyz from the panel origin, w = 1 while lit
+    int count;
+    int padding[3];
+};
+
+struct ButtonLightBuffer {
+    unsigned int buffer;
+    ButtonLightBlock uploaded;
+};
+
+void createButtonLights(ButtonLightBuffer& lights);
+void deleteButtonLights(ButtonLightBuffer& lights);
+// Returns true if the block differed from the last upload and was sent
+bool updateButtonLights(ButtonLightBuffer& lights, const ButtonLightBlock& block);
@@ -0,0 +1,208 @@
+#pragma once
+#include <vector>
+#include <random>
+#include "Elevator.h"
+#include "Traffic.h"
+#include "Assignment.h"
+#include "EtaTable.h"
+
+// Headless traffic simulation - many passengers, one or more cars, no window.
+// Cars are the same Elevator structs the 3D scene drives, stepped with stepElevator.
+
+struct Passenger {
+    int origin;
+    int destination;        // Final floor of the trip
+    int legDestination;     // Floor the current ride ends on - a transfer floor or the destination
+    int legZone;            // Zone whose cars serve the current ride
+    int deck;               // Cabin of a double-deck car - the one at their landing, or in the lobby the one for their destination
+    float weightKg;
+    float spawnTime;
+    float callTime;         // When the current ride's hall call was registered
+    float boardTime;        // -1 while still waiting on the landing
+    int car;                // -1 while waiting
+    bool delivered;
+    bool refused;           // Turned away by a full car at least once
+};
+
+// A bank of cars serving its lobby plus one contiguous range of floors.
+// Cars run express between the lobby and the range; a range of a single
+// floor makes a sky-lobby shuttle, and a zone whose lobby is a sky lobby
+// continues the trip from there.
+struct Zone {
+    int lowestFloor;
+    int highestFloor;
+    int lobbyFloor;
+    int numCars;
+};
+
+bool zoneServesFloor(const Zone& zone, int floor);
+
+struct TrafficProfile {
+    float arrivalsPerMinute;
+    int lobbyFloor;
+    float lobbyOriginShare;        // Share of trips starting at the lobby (up-peak)
+    float lobbyDestinationShare;   // Share of non-lobby trips going down to the lobby (down-peak)
+};
+
+enum class ParkingStrategy {
+    None,               // Idle car stays on its last floor
+    PredictedDemand     // Idle cars move to the floors expected to call next
+};
+
+// Hall calls per floor, bucketed by time of day and accumulated over the run
+const float DEMAND_BUCKET_SECONDS = 900.0f;
+const int DEMAND_BUCKETS_PER_DAY = 96;
+const float PARKING_HORIZON_SECONDS = 900.0f;
+const float PARKING_REVIEW_SECONDS = 10.0f;
+
+struct DemandHistory {
+    int numFloors;
+    std::vector<float> calls;   // [bucket * numFloors + floor]
+};
+
+// Cars stacked in one shaft never come closer than this, so two cars are always
+// at least a floor apart. A car held longer than SHAFT_YIELD_AFTER by the car
+// next to it makes that car step aside at its next stop.
+const float SHAFT_MIN_SEPARATION = FLOOR_HEIGHT;
+const float SHAFT_YIELD_AFTER = 15.0f;
+
+// Hall call cost = travel * travelWeight + door time ahead * stopWeight + load * loadWeight * door time,
+// with travel and door time read from the car's ETA table by greedy and batch dispatch alike
+struct DispatchParams {
+    float travelWeight;
+    float stopWeight;
+    float loadWeight;
+    bool returnToLobby;     // Idle cars head straight back to the lobby
+};
+
+// Hand-tuned weights per traffic pattern
+DispatchParams dispatchParamsFor(TrafficMode mode);
+
+// Energy-saving dispatch gives a call to the car that serves it with the least
+// drive energy, as long as that car's cost is within ENERGY_SAVING_SLACK seconds
+// of the best. Kinetic energy grows with the square of speed, so cars also cruise
+// at ECO_SPEED_FACTOR of rated speed until someone in their zone has waited that long.
+const float ENERGY_SAVING_SLACK = 10.0f;
+const float ECO_SPEED_FACTOR = 0.7f;
+
+enum class AssignmentMethod {
+    Greedy,     // Each new call goes to the car that is cheapest for it when it appears
+    Batch       // All open calls of a zone are planned together as one assignment problem
+};
+
+// Batch plans are rebuilt from fresh predicted waits this often; calls arriving
+// in between are added to the current plan incrementally
+const float ASSIGNMENT_REPLAN_SECONDS = 2.0f;
+// Cost factor for the car a call is already assigned to, so re-plans don't bounce calls between cars
+const float ASSIGNMENT_KEEP_FACTOR = 0.8f;
+
+struct SimConfig {
+    int numFloors;
+    int numCars;                // Used when no zones are given - one bank serves every floor
+    std::vector<Zone> zones;
+    int carDecks;               // 2 for double-deck cars
+    int carsPerShaft;           // Single-deck cars stacked in one shaft, bottom car reaching lowest
+    float carSpeed;
+    int capacityPersons;
+    float capacityKg;
+    float doorOpenTime;
+    float doorExtendedTime;
+    TrafficProfile traffic;
+    ParkingStrategy parking;
+    bool adaptiveDispatch;      // Switch DispatchParams with the estimated traffic pattern
+    DispatchParams dispatchByMode[TRAFFIC_MODE_COUNT];  // Indexed by TrafficMode, dispatchParamsFor by default
+    AssignmentMethod assignment;
+    bool energySaving;          // Greedy dispatch trades a bounded wait for lower kWh
+    float startTimeOfDay;       // Seconds after midnight when the run starts
+    unsigned int seed;
+};
+
+// Pre-recorded trip, spawned when the run reaches its time (alongside any random arrivals)
+struct ScheduledTrip {
+    float time;             // Seconds after the run starts
+    int origin;
+    int destination;
+    float weightKg;         // 0 draws a random weight
+};
+
+struct SimStats {
+    int spawned;
+    int boarded;
+    int delivered;
+    int refusedBoardings;       // Passengers turned away by a full car at least once
+    int bypassedHallCalls;      // Hall call skipped by a car above HALL_CALL_BYPASS_LOAD
+    int trafficModeSwitches;
+    int transfers;              // Rides changed at a transfer floor
+    int stairTrips;             // Flights walked between the two floors of a double-deck stop
+    int shaftYields;            // Moves a stacked car made only to let its neighbour pass
+    float shaftBlockedTime;     // Car-seconds spent held by a neighbour in the shaft
+    long long etaQueries;       // Car arrival estimates read by the dispatcher
+    long long etaEntriesComputed;
+    double energyUsedJ;         // Drive, doors and standby
+    double energyRecoveredJ;    // Fed back by regenerative braking and overhauling loads
+    double totalWaitTime;
+    double totalRideTime;
+    float maxWaitTime;
+};
+
+struct Simulation {
+    SimConfig config;
+    std::vector<Zone> zones;
+    std::vector<Elevator> cars;
+    std::vector<int> carZone;
+    std::vector<std::vector<int>> zoneFloors;   // Floors each zone's cars stop at, ascending
+    std::vector<std::vector<int>> shafts;       // Car ids per shaft, bottom to top
+    std::vector<int> carShaft;
+    std::vector<int> carShaftSlot;
+    std::vector<int> carLowestFloor;            // Part of its zone a stacked car can reach
+    std::vector<int> carHighestFloor;
+    std::vector<float> carBlockedSince;         // -1 unless held by a neighbour in the shaft
+    std::vector<bool> carDoorsWereOpen;
+    std::vector<Passenger> passengers;
+    std::vector<std::vector<int>> waiting;      // Passenger ids per [zone * numFloors + floor]
+    std::vector<std::vector<int>> riding;       // Passenger ids per car
+    std::vector<int> hallCallCar;               // Car answering each zone's hall call per floor, -1 if none
+    std::vector<bool> hallCallBypassed;
+    std::vector<int> routeFloor;                // First stop of the fewest-rides route [origin * numFloors + destination]
+    std::vector<int> routeZone;                 // Zone for that first ride, -1 if unreachable
+    std::vector<bool> carParking;               // Car is on an idle repositioning trip
+    DemandHistory demand;
+    double nextParkingReview;
+    TrafficEstimator traffic;
+    TrafficMode trafficMode;
+    float lastModeSwitch;
+    DispatchParams dispatch;
+    std::vector<AssignmentSolver> plans;        // Batch assignment per zone
+    std::vector<std::vector<int>> planCalls;    // Floor of each planned call per zone
+    std::vector<std::vector<int>> planCars;     // Car ids of each zone, in solver order
+    double nextReplan;
+    std::vector<EtaTable> eta;                  // Predicted arrival per car
+    std::vector<ScheduledTrip> schedule;        // Sorted by time, set after initSimulation
+    size_t nextScheduled;
+    bool recordEvents;                          // Fill the event lists below - whoever reads them clears them
+    std::vector<int> boardedEvents;             // Passenger ids, in the order it happened
+    std::vector<int> deliveredEvents;
+    double time;                                // A float sum of frame steps would drift by minutes over a day
+    double nextArrivalTime;
+    std::mt19937 rng;
+    SimStats stats;
+};
+
+void initDemandHistory(DemandHistory& history, int numFloors);
+void recordDemand(DemandHistory& history, float timeOfDay, int floor);
+// Expected hall calls per floor over [timeOfDay, timeOfDay + horizon]
+std::vector<float> predictDemand(const DemandHistory& history, float timeOfDay, float horizon);
+
+SimConfig defaultSimConfig();
+// Tall building split into low-rise and express mid-rise banks from the main lobby,
+// a shuttle to a sky lobby, and a high-rise bank above it
+SimConfig zonedTowerConfig(int numFloors);
+void initSimulation(Simulation& sim, const SimConfig& config);
+void stepSimulation(Simulation& sim, float deltaTime);
+// Starts a trip now, as a random arrival would. Returns the passenger id, or -1 if no zone serves it.
+int addPassenger(Simulation& sim, int origin, int destination, float weightKg = 0.0f);
+SimStats runSimulation(const SimConfig& config, float duration, float deltaTime);
+float averageWaitTime(const SimStats& stats);
+float energyKWh(const SimStats& stats);
+float energyPerPassengerWh(const SimStats& stats);
+void printSimStats(const SimStats& stats, float duration);
@@ -0,0 +1,25 @@
+#pragma once
+#include <vector>
+#include "Simulation.h"
+
+// Headless parameter sweep: every configuration of a grid (or a random sample
+// from the ranges the grid spans) is simulated on a work-stealing thread pool,
+// one CSV row per configuration.
+
+struct SweepSpec {
+    std::vector<int> floors;
+    std::vector<int> cars;
+    std::vector<float> speeds;
+    std::vector<float> doorOpenTimes;       // The extended dwell keeps its 2:1 ratio
+    std::vector<int> capacities;            // Persons - rated kg follows the 8 person / 630 kg cabin
+    std::vector<AssignmentMethod> assignments;
+    int randomSamples;                      // 0 runs the full grid
+    float duration;                         // Simulated seconds per configuration
+    float timeStep;                         // Seconds per simulation step, the window's frame time by default
+    unsigned int seed;
+};
+
+SweepSpec defaultSweepSpec();
+std::vector<SimConfig> sweepConfigs(const SweepSpec& spec);
+// Writes the CSV to outputPath, or stdout when it is null. threads 0 uses every core.
+bool runSweep(const SweepSpec& spec, int threads, const char* outputPath);
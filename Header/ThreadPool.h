@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads with one job deque each. A worker runs jobs from the back of
+// its own deque and, once that is empty, steals from the front of another's.
+// Jobs of very different lengths then keep every core busy until the last one
+// is taken, where a static split would leave workers idle behind the slowest batch.
+
+struct WorkQueue {
+    std::mutex lock;
+    std::deque<std::function<void()>> jobs;
+};
+
+struct ThreadPool {
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::atomic<int> queued{0};         // Jobs sitting in a deque
+    std::atomic<int> pending{0};        // Jobs submitted and not finished yet
+    std::atomic<long long> steals{0};
+    bool stopping = false;
+    int nextQueue = 0;
+    std::mutex idleLock;
+    std::condition_variable wake;
+    std::condition_variable done;
+};
+
+// numThreads 0 uses every hardware thread
+void startThreadPool(ThreadPool& pool, int numThreads);
+void stopThreadPool(ThreadPool& pool);
+// Jobs are dealt round-robin over the worker deques
+void submitJob(ThreadPool& pool, std::function<void()> job);
+void waitForJobs(ThreadPool& pool);
+// Runs job(0) .. job(count - 1) on the pool and waits for all of them
+void runJobs(ThreadPool& pool, int count, const std::function<void(int)>& job);
@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "Elevator.h"
+#include "Simulation.h"
+
+// Recorded simulation trace for the replay viewer. The state of every car and
+// the number of people waiting per floor are sampled every TRACE_SAMPLE_INTERVAL.
+// A full keyframe is written every TRACE_KEYFRAME_INTERVAL and the samples in
+// between store only what changed since the previous one (empty samples are
+// skipped). The file ends with an index of keyframe offsets, so a seek reads one
+// keyframe segment and applies at most a keyframe interval's worth of deltas -
+// the cost does not depend on how far into the trace the seek lands.
+//
+// File layout: TraceHeader, records, TraceIndexEntry[keyframes], TraceFooter.
+// Record: uint8 kind, uint32 sample, then
+//   keyframe: TraceCar[numCars], uint16 waiting[numFloors]
+//   delta:    uint16 cars, {uint16 car, uint8 TRACE_FIELD_* mask, fields}[cars],
+//             uint16 floors, {uint16 floor, uint16 waiting}[floors]
+
+const float TRACE_SAMPLE_INTERVAL = 0.1f;
+const float TRACE_KEYFRAME_INTERVAL = 10.0f;
+const uint32_t TRACE_VERSION = 2;
+const int TRACE_STOP_WORDS = (TRAFFIC_MAX_FLOORS + 63) / 64;
+
+// TraceCar::flags
+const uint8_t TRACE_MOVING = 1;
+const uint8_t TRACE_DOORS_OPEN = 2;
+const uint8_t TRACE_DOUBLE_DECK = 4;
+
+// Delta field mask
+const uint8_t TRACE_FIELD_Y = 1;
+const uint8_t TRACE_FIELD_STATE = 2;    // currentFloor, targetFloor, passengers, flags
+const uint8_t TRACE_FIELD_STOPS = 4;
+
+struct TraceHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t numFloors;
+    int32_t numCars;
+    float sampleInterval;
+    float keyframeInterval;
+    float startTimeOfDay;
+};
+
+struct TraceCar {
+    float y;
+    int16_t currentFloor;
+    int16_t targetFloor;                // Where a moving car is heading - not always its nearest stop
+    int16_t passengers;
+    uint8_t flags;
+    uint8_t padding[5];
+    uint64_t stops[TRACE_STOP_WORDS];   // Target and queued floors, one bit each
+};
+
+struct TraceIndexEntry {
+    uint32_t sample;
+    uint32_t padding;
+    uint64_t offset;
+};
+
+struct TraceFooter {
+    uint64_t indexOffset;
+    uint32_t keyframes;
+    char magic[4];
+};
+
+struct TraceFrame {
+    uint32_t sample;
+    std::vector<TraceCar> cars;
+    std::vector<uint16_t> waiting;      // People waiting per floor, over all zones
+};
+
+struct TraceWriter {
+    FILE* file;
+    TraceHeader header;
+    uint32_t samplesPerKeyframe;
+    uint32_t sample;
+    TraceFrame last;
+    TraceFrame current;
+    std::vector<TraceIndexEntry> index;
+    std::vector<unsigned char> record;
+    uint64_t offset;
+    uint64_t keyframeBytes;
+    uint64_t deltaBytes;
+};
+
+struct TraceReader {
+    FILE* file;
+    TraceHeader header;
+    std::vector<TraceIndexEntry> index;
+    uint64_t indexOffset;
+    int segment;                        // Keyframe segment held in "bytes", -1 if none
+    std::vector<unsigned char> bytes;
+    size_t position;                    // Next record of the segment not yet applied
+    TraceFrame frame;                   // State at frame.sample
+    long long segmentsLoaded;
+};
+
+void captureTraceFrame(const Simulation& sim, TraceFrame& frame);
+bool traceStopsAt(const TraceCar& car, int floor);
+// Puts a replayed car's state into the Elevator the 3D scene draws
+void applyTraceCar(const TraceCar& car, Elevator& elevator);
+
+bool openTraceWriter(TraceWriter& writer, const char* path, const Simulation& sim);
+// Call once per TRACE_SAMPLE_INTERVAL of simulated time
+void writeTraceSample(TraceWriter& writer, const Simulation& sim);
+bool closeTraceWriter(TraceWriter& writer);
+
+bool openTrace(TraceReader& reader, const char* path);
+void closeTrace(TraceReader& reader);
+float traceDuration(const TraceReader& reader);
+// Brings reader.frame to the state at "time" seconds into the trace
+void seekTrace(TraceReader& reader, float time);
+
+// Simulates "duration" seconds and writes its trace to "path"
+bool recordTrace(const SimConfig& config, float duration, float deltaTime, const char* path);
+void benchmarkTraceSeeks(const char* path, int seeks);
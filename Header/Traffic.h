@@ -0,0 +1,41 @@
+#pragma once
+
+// Online origin/destination rate estimation for the dispatcher.
+// Every observed call adds an exponentially decaying impulse to its O/D cell.
+// Instead of decaying the whole table each step, new impulses are scaled up by
+// e^((t - epoch) / tau), so an update touches one cell and a few totals (O(1));
+// the table is renormalised only when that scale nears float range.
+
+const int TRAFFIC_MAX_FLOORS = 128;
+const float TRAFFIC_TIME_CONSTANT = 300.0f;    // Seconds for a call's weight to fall to 1/e
+const float TRAFFIC_MODE_MIN_DWELL = 120.0f;   // Seconds a pattern must hold before switching again
+const float TRAFFIC_MIN_CALLS = 3.0f;          // Decayed calls needed before classifying at all
+
+enum class TrafficMode {
+    UpPeak,         // Most trips start at the lobby
+    DownPeak,       // Most trips end at the lobby
+    TwoWay,         // Heavy lobby traffic both ways (lunch time)
+    Interfloor      // Trips between upper floors
+};
+
+const int TRAFFIC_MODE_COUNT = 4;
+
+struct TrafficEstimator {
+    int lobbyFloor;
+    float timeConstant;
+    float epoch;
+    float od[TRAFFIC_MAX_FLOORS][TRAFFIC_MAX_FLOORS];
+    double total;
+    double fromLobby;
+    double toLobby;
+};
+
+void initTrafficEstimator(TrafficEstimator& estimator, int lobbyFloor, float timeConstant);
+void observeCall(TrafficEstimator& estimator, float time, int origin, int destination);
+
+// Calls per second, as seen at "time"
+float estimatedRate(const TrafficEstimator& estimator, float time, int origin, int destination);
+float estimatedTotalRate(const TrafficEstimator& estimator, float time);
+
+TrafficMode classifyTraffic(const TrafficEstimator& estimator, float time, TrafficMode current);
+const char* trafficModeName(TrafficMode mode);
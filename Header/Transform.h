@@ -0,0 +1,23 @@
+#pragma once
+#include "Util.h"
+
+// Transform work for scenes with many floors and agents. The Mat4 product in
+// Util.h runs on SSE (NEON on ARM, scalar otherwise); the functions here apply
+// it to whole arrays and replace general inverses with closed forms for the
+// affine matrices the scene is built from.
+
+// out[i] = parent * locals[i]; out may alias locals
+void composeTransforms(const Mat4& parent, const Mat4* locals, Mat4* out, int count);
+// out[i] = Mat4::placement(positions[i], yaws[i], sizes[i])
+void placeTransforms(const Vec3* positions, const float* yaws, const Vec3* sizes, Mat4* out, int count);
+
+// Inverse of a matrix whose last row is 0 0 0 1 (rotation, scale and
+// translation): the 3x3 inverse from cross products of its columns, then the
+// translation moved back through it. Singular matrices give the identity.
+Mat4 affineInverse(const Mat4& mat);
+// Inverse transpose of the upper 3x3, in the upper 3x3 of the result, for
+// transforming normals under non-uniform scale
+Mat4 normalMatrix(const Mat4& mat);
+
+// Times the kernels above against the scalar code they replace
+void benchmarkMath(int count, int runs);
@@ -5,6 +5,14 @@
 #include <cmath>
 #include <vector>
 
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MATH_SSE 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MATH_NEON 1
+#endif
+
 // Math structures for 3D
 struct Vec3 {
     float x, y, z;
@@ -20,7 +28,7 @@ struct Vec3 {
     float length() const { return sqrt(x*x + y*y + z*z); }
     Vec3 normalize() const { 
         float len = length(); 
-        if (len > 0) return Vec3(x/len, y/len, z/len);
+        if (len > 0) return *this * (1.0f / len);
         return Vec3(0,0,0);
     }
     
@@ -33,13 +41,11 @@ struct Vec3 {
     }
 };
 
-struct Mat4 {
+// Column-major, 16-byte aligned so each column is one SSE/NEON register
+struct alignas(16) Mat4 {
     float m[16];
     
-    Mat4() { 
-        for (int i = 0; i < 16; i++) m[i] = 0; 
-        m[0] = m[5] = m[10] = m[15] = 1;
-    }
+    Mat4() : m{1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1} {}
     
     static Mat4 identity() { return Mat4(); }
     
@@ -104,8 +110,42 @@ struct Mat4 {
         return result;
     }
     
+    // Placement of a prop: translate(position) * rotateY(yaw) * scale(size), built directly
+    static Mat4 placement(const Vec3& position, float yaw, const Vec3& size) {
+        Mat4 result;
+        float c = cos(yaw);
+        float s = sin(yaw);
+        result.m[0] = c * size.x; result.m[8] = s * size.z;
+        result.m[5] = size.y;
+        result.m[2] = -s * size.x; result.m[10] = c * size.z;
+        result.m[12] = position.x;
+        result.m[13] = position.y;
+        result.m[14] = position.z;
+        return result;
+    }
+    
+    // Column j of the product is the columns of this matrix weighted by column j of other
     Mat4 operator*(const Mat4& other) const {
         Mat4 result;
+#if defined(MATH_SSE)
+        __m128 c0 = _mm_load_ps(m), c1 = _mm_load_ps(m + 4), c2 = _mm_load_ps(m + 8), c3 = _mm_load_ps(m + 12);
+        for (int j = 0; j < 4; j++) {
+            const float* b = other.m + j*4;
+            __m128 column = _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(b[0])), _mm_mul_ps(c1, _mm_set1_ps(b[1])));
+            column = _mm_add_ps(column, _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(b[2])), _mm_mul_ps(c3, _mm_set1_ps(b[3]))));
+            _mm_store_ps(result.m + j*4, column);
+        }
+#elif defined(MATH_NEON)
+        float32x4_t c0 = vld1q_f32(m), c1 = vld1q_f32(m + 4), c2 = vld1q_f32(m + 8), c3 = vld1q_f32(m + 12);
+        for (int j = 0; j < 4; j++) {
+            const float* b = other.m + j*4;
+            float32x4_t column = vmulq_n_f32(c0, b[0]);
+            column = vmlaq_n_f32(column, c1, b[1]);
+            column = vmlaq_n_f32(column, c2, b[2]);
+            column = vmlaq_n_f32(column, c3, b[3]);
+            vst1q_f32(result.m + j*4, column);
+        }
+#else
         for (int i = 0; i < 4; i++) {
             for (int j = 0; j < 4; j++) {
                 result.m[i + j*4] = 0;
@@ -114,10 +154,13 @@ struct Mat4 {
                 }
             }
         }
+#endif
         return result;
     }
 };
 
+struct ShaderProgram;
+
 // OBJ Model structure
 struct OBJModel {
     unsigned int VAO;
@@ -133,19 +176,16 @@ unsigned loadImageToTexture(const char* filePath);
 GLFWcursor* loadImageToCursor(const char* filePath);
 
 void setTextureFiltering(unsigned int texture);
-void renderQuad(unsigned int VAO, unsigned int texture, unsigned int shader, float x, float y, float width, float height, float alpha = 1.0f);
-void renderColorQuad(unsigned int VAO, unsigned int shader, float x, float y, float width, float height, float r, float g, float b, float a);
+void renderQuad(unsigned int VAO, unsigned int texture, const ShaderProgram& shader, float x, float y, float width, float height, float alpha = 1.0f);
+void renderColorQuad(unsigned int VAO, const ShaderProgram& shader, float x, float y, float width, float height, float r, float g, float b, float a);
 
 // 3D rendering functions
-void setShaderMat4(unsigned int shader, const char* name, const Mat4& mat);
-void setShaderVec3(unsigned int shader, const char* name, const Vec3& vec);
-void setShaderFloat(unsigned int shader, const char* name, float value);
 unsigned int create3DQuadVAO();
 unsigned int createWallVAO();
 unsigned int createCubeVAO();
-void render3DQuad(unsigned int VAO, unsigned int texture, unsigned int shader, const Mat4& model, const Mat4& view, const Mat4& projection, const Vec3& lightPos, const Vec3& viewPos);
-void render3DColorQuad(unsigned int VAO, unsigned int shader, const Mat4& model, const Mat4& view, const Mat4& projection, const Vec3& lightPos, float r, float g, float b, float a);
+void render3DQuad(unsigned int VAO, unsigned int texture, const ShaderProgram& shader, const Mat4& model);
+void render3DColorQuad(unsigned int VAO, const ShaderProgram& shader, const Mat4& model, float r, float g, float b, float a);
 
 // OBJ Model loading
 OBJModel loadOBJModel(const char* objPath, const char* texturePath);
-void renderOBJModel(const OBJModel& model, unsigned int shader, const Mat4& modelMatrix, const Mat4& view, const Mat4& projection, const Vec3& lightPos, const Vec3& viewPos);
\ No newline at end of file
+void renderOBJModel(const OBJModel& model, const ShaderProgram& shader, const Mat4& modelMatrix);
\ No newline at end of file
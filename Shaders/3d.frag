@@ -3,26 +3,35 @@
 in vec2 TexCoords;
 in vec3 FragPos;
 in vec3 Normal;
+in float Ambient;           // uAmbientStrength, or the instance's own
 
 out vec4 FragColor;
 
 uniform sampler2D uTexture;
 uniform float uAlpha;
-uniform vec3 uLightPos;
-uniform vec3 uViewPos;
-uniform vec3 uLightColor;
-uniform float uAmbientStrength;
+// Light pass, bound per pass from the frame's uniform buffer
+layout(std140) uniform Light {
+    vec3 uLightPos;
+    float uConstant;    // Usually 1.0
+    vec3 uLightColor;
+    float uLinear;      // Distance-based falloff
+    float uQuadratic;   // Distance-squared falloff
+};
 
-// Attenuation parameters for point light
-uniform float uConstant;    // Usually 1.0
-uniform float uLinear;      // Distance-based falloff
-uniform float uQuadratic;   // Distance-squared falloff
+// Same block as in 3d.vert - only the panel origin is read here
+layout(std140) uniform Frame {
+    mat4 uView;
+    mat4 uProjection;
+    vec3 uViewPos;
+    vec3 uPanelOrigin;
+};
 
 // Button lights (small point lights when buttons are pressed)
 #define MAX_BUTTON_LIGHTS 12
-uniform vec3 uButtonLightPos[MAX_BUTTON_LIGHTS];
-uniform int uButtonLightActive[MAX_BUTTON_LIGHTS];
-uniform int uNumButtonLights;
+layout(std140) uniform ButtonLights {
+    vec4 uButtonLights[MAX_BUTTON_LIGHTS];  // xyz from uPanelOrigin, w = 1 while lit
+    int uNumButtonLights;
+};
 
 vec3 calculatePointLight(vec3 lightPos, vec3 lightColor, float constant, float linear, float quadratic, float intensityBoost)
 {
@@ -39,7 +48,7 @@ vec3 calculatePointLight(vec3 lightPos, vec3 lightColor, float constant, float l
 void main()
 {
     // Ambient - moderate base lighting
-    vec3 ambient = uAmbientStrength * uLightColor;
+    vec3 ambient = Ambient * uLightColor;
     
     // Main light diffuse
     vec3 diffuse = calculatePointLight(uLightPos, uLightColor, uConstant, uLinear, uQuadratic, 3.5);
@@ -47,9 +56,9 @@ void main()
     // Button lights contribution (strong local glow)
     vec3 buttonLightColor = vec3(1.0, 0.9, 0.5);  // Warm yellow color
     for (int i = 0; i < uNumButtonLights; i++) {
-        if (uButtonLightActive[i] == 1) {
+        if (uButtonLights[i].w > 0.5) {
             // Short range but strong intensity - bright glow around the button
-            diffuse += calculatePointLight(uButtonLightPos[i], buttonLightColor, 1.0, 2.5, 8.0, 4.5);
+            diffuse += calculatePointLight(uPanelOrigin + uButtonLights[i].xyz, buttonLightColor, 1.0, 2.5, 8.0, 4.5);
         }
     }
     
@@ -7,16 +7,28 @@ layout(location = 2) in vec3 inNormal;
 out vec2 TexCoords;
 out vec3 FragPos;
 out vec3 Normal;
+out float Ambient;
+flat out int Layer;         // Only read by 3d_array.frag
 
 uniform mat4 uModel;
-uniform mat4 uView;
-uniform mat4 uProjection;
+uniform float uAmbientStrength;
+uniform int uLayer;
+
+// Written once per frame, shared with 3d_color
+layout(std140) uniform Frame {
+    mat4 uView;
+    mat4 uProjection;
+    vec3 uViewPos;
+    vec3 uPanelOrigin;
+};
 
 void main()
 {
     FragPos = vec3(uModel * vec4(inPos, 1.0));
     Normal = mat3(transpose(inverse(uModel))) * inNormal;
     TexCoords = inTexCoords;
+    Ambient = uAmbientStrength;
+    Layer = uLayer;
     
     gl_Position = uProjection * uView * uModel * vec4(inPos, 1.0);
 }
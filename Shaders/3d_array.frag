@@ -0,0 +1,72 @@
+#version 330 core
+
+in vec2 TexCoords;
+in vec3 FragPos;
+in vec3 Normal;
+in float Ambient;           // uAmbientStrength, or the instance's own
+flat in int Layer;          // uLayer, or the instance's material
+
+out vec4 FragColor;
+
+// Same lighting as 3d.frag, sampling one layer of a texture array
+uniform sampler2DArray uTextures;
+uniform float uAlpha;
+// Light pass, bound per pass from the frame's uniform buffer
+layout(std140) uniform Light {
+    vec3 uLightPos;
+    float uConstant;    // Usually 1.0
+    vec3 uLightColor;
+    float uLinear;      // Distance-based falloff
+    float uQuadratic;   // Distance-squared falloff
+};
+
+// Same block as in 3d.vert - only the panel origin is read here
+layout(std140) uniform Frame {
+    mat4 uView;
+    mat4 uProjection;
+    vec3 uViewPos;
+    vec3 uPanelOrigin;
+};
+
+// Button lights (small point lights when buttons are pressed)
+#define MAX_BUTTON_LIGHTS 12
+layout(std140) uniform ButtonLights {
+    vec4 uButtonLights[MAX_BUTTON_LIGHTS];  // xyz from uPanelOrigin, w = 1 while lit
+    int uNumButtonLights;
+};
+
+vec3 calculatePointLight(vec3 lightPos, vec3 lightColor, float constant, float linear, float quadratic, float intensityBoost)
+{
+    float distance = length(lightPos - FragPos);
+    float attenuation = 1.0 / (constant + linear * distance + quadratic * distance * distance);
+    
+    vec3 norm = normalize(Normal);
+    vec3 lightDir = normalize(lightPos - FragPos);
+    float diff = max(dot(norm, lightDir), 0.0);
+    
+    return diff * lightColor * attenuation * intensityBoost;
+}
+
+void main()
+{
+    // Ambient - moderate base lighting
+    vec3 ambient = Ambient * uLightColor;
+    
+    // Main light diffuse
+    vec3 diffuse = calculatePointLight(uLightPos, uLightColor, uConstant, uLinear, uQuadratic, 3.5);
+    
+    // Button lights contribution (strong local glow)
+    vec3 buttonLightColor = vec3(1.0, 0.9, 0.5);  // Warm yellow color
+    for (int i = 0; i < uNumButtonLights; i++) {
+        if (uButtonLights[i].w > 0.5) {
+            // Short range but strong intensity - bright glow around the button
+            diffuse += calculatePointLight(uPanelOrigin + uButtonLights[i].xyz, buttonLightColor, 1.0, 2.5, 8.0, 4.5);
+        }
+    }
+    
+    // Combine
+    vec4 texColor = texture(uTextures, vec3(TexCoords, Layer));
+    vec3 result = (ambient + diffuse) * texColor.rgb;
+    
+    FragColor = vec4(result, texColor.a * uAlpha);
+}
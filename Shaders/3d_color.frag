@@ -3,18 +3,19 @@
 in vec2 TexCoords;
 in vec3 FragPos;
 in vec3 Normal;
+in float Ambient;           // uAmbientStrength from 3d.vert
 
 out vec4 FragColor;
 
 uniform vec4 uColor;
-uniform vec3 uLightPos;
-uniform vec3 uLightColor;
-uniform float uAmbientStrength;
-
-// Attenuation parameters for point light
-uniform float uConstant;    // Usually 1.0
-uniform float uLinear;      // Distance-based falloff
-uniform float uQuadratic;   // Distance-squared falloff
+// Light pass, bound per pass from the frame's uniform buffer
+layout(std140) uniform Light {
+    vec3 uLightPos;
+    float uConstant;    // Usually 1.0
+    vec3 uLightColor;
+    float uLinear;      // Distance-based falloff
+    float uQuadratic;   // Distance-squared falloff
+};
 
 void main()
 {
@@ -25,7 +26,7 @@ void main()
     float attenuation = 1.0 / (uConstant + uLinear * distance + uQuadratic * distance * distance);
     
     // Ambient - moderate base lighting
-    vec3 ambient = uAmbientStrength * uLightColor;
+    vec3 ambient = Ambient * uLightColor;
     
     // Diffuse with strong intensity for bright areas near light
     vec3 norm = normalize(Normal);
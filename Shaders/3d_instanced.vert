@@ -0,0 +1,35 @@
+#version 330 core
+
+layout(location = 0) in vec3 inPos;
+layout(location = 1) in vec2 inTexCoords;
+layout(location = 2) in vec3 inNormal;
+
+// Per instance (see Header/Instancing.h)
+layout(location = 3) in mat4 inModel;
+layout(location = 7) in float inAmbient;
+layout(location = 8) in int inMaterial;
+
+out vec2 TexCoords;
+out vec3 FragPos;
+out vec3 Normal;
+out float Ambient;
+flat out int Layer;
+
+// Written once per frame, shared with 3d.vert
+layout(std140) uniform Frame {
+    mat4 uView;
+    mat4 uProjection;
+    vec3 uViewPos;
+    vec3 uPanelOrigin;
+};
+
+void main()
+{
+    FragPos = vec3(inModel * vec4(inPos, 1.0));
+    Normal = mat3(transpose(inverse(inModel))) * inNormal;
+    TexCoords = inTexCoords;
+    Ambient = inAmbient;
+    Layer = inMaterial;
+    
+    gl_Position = uProjection * uView * inModel * vec4(inPos, 1.0);
+}
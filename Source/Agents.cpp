@@ -0,0 +1,254 @@
+#include "../Header/Agents.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+
+AgentFramePool& agentFramePool()
+{
+    static AgentFramePool pool = {};
+    return pool;
+}
+
+static int frameClass(size_t size)
+{
+    return (int)((size + AGENT_FRAME_CLASS - 1) / AGENT_FRAME_CLASS) - 1;
+}
+
+static size_t frameBytes(size_t size)
+{
+    int sizeClass = frameClass(size);
+    return sizeClass < AGENT_FRAME_CLASSES ? (sizeClass + 1) * AGENT_FRAME_CLASS : size;
+}
+
+void* AgentTask::promise_type::operator new(size_t size)
+{
+    AgentFramePool& pool = agentFramePool();
+    int sizeClass = frameClass(size);
+    void* frame;
+    if (sizeClass < AGENT_FRAME_CLASSES && !pool.freeFrames[sizeClass].empty()) {
+        frame = pool.freeFrames[sizeClass].back();
+        pool.freeFrames[sizeClass].pop_back();
+        pool.reused++;
+    } else {
+        frame = ::operator new(frameBytes(size));
+        pool.allocated++;
+    }
+    pool.live++;
+    pool.peakLive = std::max(pool.peakLive, pool.live);
+    pool.liveBytes += frameBytes(size);
+    return frame;
+}
+
+void AgentTask::promise_type::operator delete(void* frame, size_t size)
+{
+    AgentFramePool& pool = agentFramePool();
+    int sizeClass = frameClass(size);
+    pool.live--;
+    pool.liveBytes -= frameBytes(size);
+    if (sizeClass < AGENT_FRAME_CLASSES) pool.freeFrames[sizeClass].push_back(frame);
+    else ::operator delete(frame);
+}
+
+void AgentTask::promise_type::return_void()
+{
+    if (world) world->finished++;
+}
+
+void AgentTask::promise_type::unhandled_exception()
+{
+    std::abort();
+}
+
+void SleepAwaiter::await_suspend(std::coroutine_handle<> agent)
+{
+    world.timers.push({wakeTime, world.timerOrder++, agent});
+}
+
+bool CallAwaiter::await_suspend(std::coroutine_handle<> agent)
+{
+    passenger = addPassenger(world.sim, origin, destination);
+    if (passenger < 0) return false;
+    world.boardWaiters[passenger] = agent;
+    return true;
+}
+
+void ArrivalAwaiter::await_suspend(std::coroutine_handle<> agent)
+{
+    world.arrivalWaiters[passenger] = agent;
+}
+
+SleepAwaiter sleepFor(AgentWorld& world, float seconds)
+{
+    return {world, world.sim.time + seconds};
+}
+
+SleepAwaiter sleepUntil(AgentWorld& world, double time)
+{
+    return {world, time};
+}
+
+CallAwaiter callElevator(AgentWorld& world, int origin, int destination)
+{
+    return {world, origin, destination, -1};
+}
+
+ArrivalAwaiter rideUntilArrived(AgentWorld& world, int passenger)
+{
+    return {world, passenger};
+}
+
+void initAgentWorld(AgentWorld& world, const SimConfig& config)
+{
+    initSimulation(world.sim, config);
+    world.sim.recordEvents = true;
+    world.timers = {};
+    world.timerOrder = 0;
+    world.boardWaiters.clear();
+    world.arrivalWaiters.clear();
+    world.started = world.finished = world.peakSuspended = 0;
+}
+
+void startAgent(AgentWorld& world, AgentTask task)
+{
+    task.handle.promise().world = &world;
+    world.started++;
+    task.handle.resume();
+}
+
+int suspendedAgents(const AgentWorld& world)
+{
+    return world.started - world.finished;
+}
+
+// Resumes the agent waiting on this passenger in "waiters", if any
+static void wake(std::unordered_map<int, std::coroutine_handle<>>& waiters, int passenger)
+{
+    auto it = waiters.find(passenger);
+    if (it == waiters.end()) return;
+    std::coroutine_handle<> agent = it->second;
+    waiters.erase(it);
+    agent.resume();
+}
+
+void stepAgentWorld(AgentWorld& world, float deltaTime)
+{
+    stepSimulation(world.sim, deltaTime);
+
+    // Resumed agents may call again and add events - take this step's lists first
+    std::vector<int> boarded, delivered;
+    boarded.swap(world.sim.boardedEvents);
+    delivered.swap(world.sim.deliveredEvents);
+    for (int id : boarded) wake(world.boardWaiters, id);
+    for (int id : delivered) {
+        wake(world.boardWaiters, id);       // Walked the stairs without boarding
+        wake(world.arrivalWaiters, id);
+    }
+
+    while (!world.timers.empty() && world.timers.top().time <= world.sim.time) {
+        std::coroutine_handle<> agent = world.timers.top().agent;
+        world.timers.pop();
+        agent.resume();
+    }
+    world.peakSuspended = std::max(world.peakSuspended, suspendedAgents(world));
+}
+
+void shutdownAgentWorld(AgentWorld& world)
+{
+    while (!world.timers.empty()) {
+        world.timers.top().agent.destroy();
+        world.timers.pop();
+    }
+    for (auto& waiter : world.boardWaiters) waiter.second.destroy();
+    for (auto& waiter : world.arrivalWaiters) waiter.second.destroy();
+    world.boardWaiters.clear();
+    world.arrivalWaiters.clear();
+    world.finished = world.started;
+}
+
+// Walking between the street door, the hall and a desk
+static float walkSeconds(AgentWorld& world)
+{
+    std::uniform_real_distribution<float> walk(15.0f, 60.0f);
+    return walk(world.sim.rng);
+}
+
+
+AgentTask officeWorker(AgentWorld& world, int deskFloor, float arrival, float lunch, float leave)
+{
+    int lobby = world.sim.config.traffic.lobbyFloor;
+
+    co_await sleepUntil(world, arrival);
+    co_await sleepFor(world, walkSeconds(world));
+    int trip = co_await callElevator(world, lobby, deskFloor);
+    co_await rideUntilArrived(world, trip);
+    co_await sleepFor(world, walkSeconds(world));
+
+    co_await sleepUntil(world, lunch);
+    co_await sleepFor(world, walkSeconds(world));
+    trip = co_await callElevator(world, deskFloor, lobby);
+    co_await rideUntilArrived(world, trip);
+    co_await sleepFor(world, 1800.0f + walkSeconds(world) * 10.0f);
+    trip = co_await callElevator(world, lobby, deskFloor);
+    co_await rideUntilArrived(world, trip);
+
+    co_await sleepUntil(world, leave);
+    co_await sleepFor(world, walkSeconds(world));
+    trip = co_await callElevator(world, deskFloor, lobby);
+    co_await rideUntilArrived(world, trip);
+}
+
+// Sleeps until the world shuts down - measures the cost of a parked agent
+static AgentTask parkedAgent(AgentWorld& world)
+{
+    co_await sleepUntil(world, 1e30f);
+}
+
+void runAgentDay(int numAgents, int numParked)
+{
+    SimConfig config = defaultSimConfig();
+    config.traffic.arrivalsPerMinute = 0.0f;        // Every trip comes from a script
+    config.startTimeOfDay = 7.0f * 3600.0f;
+    const float day = 12.0f * 3600.0f;
+    const float deltaTime = 0.1f;
+
+    AgentWorld world;
+    initAgentWorld(world, config);
+
+    // Times are relative to the start of the run at 7:00
+    std::mt19937 rng(config.seed);
+    std::normal_distribution<float> arrival(1.5f * 3600.0f, 1200.0f);
+    std::normal_distribution<float> lunch(5.5f * 3600.0f, 1500.0f);
+    std::normal_distribution<float> leave(10.5f * 3600.0f, 1500.0f);
+    std::uniform_int_distribution<int> desk(0, config.numFloors - 1);
+    for (int i = 0; i < numAgents; i++) {
+        int floor;
+        do { floor = desk(rng); } while (floor == config.traffic.lobbyFloor);
+        startAgent(world, officeWorker(world, floor, std::max(0.0f, arrival(rng)), lunch(rng), leave(rng)));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    while (world.sim.time < day) stepAgentWorld(world, deltaTime);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const SimStats& stats = world.sim.stats;
+    std::cout << numAgents << " office workers: " << stats.spawned << " elevator trips, " << stats.delivered << " delivered, "
+              << world.finished << " finished their day (" << seconds << " s)" << std::endl;
+    std::cout << "Average wait:        " << averageWaitTime(stats) << " s (max " << stats.maxWaitTime << " s)" << std::endl;
+    std::cout << "Peak suspended:      " << world.peakSuspended << " agents" << std::endl;
+    shutdownAgentWorld(world);
+
+    // Two rounds of parked agents - the second one runs entirely on recycled frames
+    AgentFramePool& pool = agentFramePool();
+    for (int round = 0; round < 2; round++) {
+        long long allocated = pool.allocated, reused = pool.reused;
+        for (int i = 0; i < numParked; i++) startAgent(world, parkedAgent(world));
+        std::cout << "Parked agents:       " << numParked << " suspended, " << pool.liveBytes << " bytes of frames ("
+                  << (numParked > 0 ? pool.liveBytes / numParked : 0) << " per agent), " << pool.allocated - allocated
+                  << " frames allocated, " << pool.reused - reused << " recycled" << std::endl;
+        shutdownAgentWorld(world);
+    }
+}
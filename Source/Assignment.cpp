@@ -0,0 +1,226 @@
+#include "../Header/Assignment.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+
+void resetAssignment(AssignmentSolver& solver, int numCars, int numSlots, float slotCost)
+{
+    int columns = numCars * numSlots;
+    solver.numCars = numCars;
+    solver.numSlots = numSlots;
+    solver.slotCost = slotCost;
+    solver.numCalls = 0;
+    solver.cost.clear();
+    solver.callColumn.clear();
+    solver.columnCall.assign(columns + 1, 0);
+    solver.callPotential.assign(1, 0.0);
+    solver.columnPotential.assign(columns + 1, 0.0);
+    solver.columnDist.resize(columns + 1);
+    solver.way.resize(columns + 1);
+    solver.columnDone.resize(columns + 1);
+    solver.carDist.resize(numCars);
+    solver.carWay.resize(numCars);
+    solver.carOffset.resize(numCars);
+    solver.carSlot.resize(numCars);
+}
+
+// Cheapest slot of the car the current search has not reached yet
+static void updateCarOffset(AssignmentSolver& solver, int car)
+{
+    double best = std::numeric_limits<double>::infinity();
+    int bestSlot = -1;
+    for (int slot = 0; slot < solver.numSlots; slot++) {
+        int j = car * solver.numSlots + slot + 1;
+        if (solver.columnDone[j]) continue;
+        double offset = slot * solver.slotCost - solver.columnPotential[j];
+        if (offset < best) {
+            best = offset;
+            bestSlot = slot;
+        }
+    }
+    solver.carOffset[car] = best;
+    solver.carSlot[car] = bestSlot;
+}
+
+// Dijkstra over reduced costs from the new call until the path reaches a free
+// slot. Potentials are settled once at the end (Jonker-Volgenant) instead of
+// shifting every column on every step.
+static void augmentCall(AssignmentSolver& solver, int call)
+{
+    int cars = solver.numCars;
+    std::vector<int>& p = solver.columnCall;
+    std::vector<double>& u = solver.callPotential;
+    std::vector<double>& v = solver.columnPotential;
+    std::vector<double>& dist = solver.columnDist;
+    const double inf = std::numeric_limits<double>::infinity();
+
+    std::fill(solver.columnDone.begin(), solver.columnDone.end(), 0);
+    std::fill(solver.carDist.begin(), solver.carDist.end(), inf);
+    for (int car = 0; car < cars; car++) updateCarOffset(solver, car);
+    solver.doneColumns.clear();
+
+    p[0] = call + 1;
+    dist[0] = 0.0;
+    int j0 = 0;
+    double reached = 0.0;
+    do {
+        solver.doneColumns.push_back(j0);
+        int i0 = p[j0];
+        const float* costs = &solver.cost[(size_t)(i0 - 1) * cars];
+        double base = reached - u[i0];
+        double best = inf;
+        int bestCar = -1;
+        for (int car = 0; car < cars; car++) {
+            if (solver.carSlot[car] < 0) continue;
+            double d = base + costs[car];
+            if (d < solver.carDist[car]) {
+                solver.carDist[car] = d;
+                solver.carWay[car] = j0;
+            }
+            double total = solver.carDist[car] + solver.carOffset[car];
+            if (total < best) {
+                best = total;
+                bestCar = car;
+            }
+        }
+        j0 = bestCar * solver.numSlots + solver.carSlot[bestCar] + 1;
+        dist[j0] = best;
+        solver.way[j0] = solver.carWay[bestCar];
+        solver.columnDone[j0] = 1;
+        updateCarOffset(solver, bestCar);
+        reached = best;
+    } while (p[j0] != 0);
+
+    for (int j : solver.doneColumns) {
+        u[p[j]] += reached - dist[j];
+        if (j != 0) v[j] -= reached - dist[j];
+    }
+
+    // Flip the path - every call on it moves to the next column
+    do {
+        int j1 = solver.way[j0];
+        p[j0] = p[j1];
+        solver.callColumn[p[j0] - 1] = j0 - 1;
+        j0 = j1;
+    } while (j0 != 0);
+}
+
+bool addAssignmentCall(AssignmentSolver& solver, const float* carCosts)
+{
+    if (solver.numCalls >= solver.numCars * solver.numSlots) return false;
+
+    int call = solver.numCalls++;
+    solver.cost.insert(solver.cost.end(), carCosts, carCosts + solver.numCars);
+    solver.callPotential.push_back(0.0);
+    solver.callColumn.push_back(-1);
+    augmentCall(solver, call);
+    return true;
+}
+
+void solveAssignment(AssignmentSolver& solver, int numCalls, const float* costs)
+{
+    resetAssignment(solver, solver.numCars, solver.numSlots, solver.slotCost);
+    for (int call = 0; call < numCalls; call++) {
+        if (!addAssignmentCall(solver, costs + (size_t)call * solver.numCars)) break;
+    }
+}
+
+int assignedCar(const AssignmentSolver& solver, int call)
+{
+    int column = solver.callColumn[call];
+    if (column < 0) return -1;
+    int car = column / solver.numSlots;
+    if (solver.cost[(size_t)call * solver.numCars + car] >= ASSIGNMENT_INFEASIBLE) return -1;
+    return car;
+}
+
+float totalAssignmentCost(const AssignmentSolver& solver)
+{
+    float total = 0.0f;
+    for (int call = 0; call < solver.numCalls; call++) {
+        int car = assignedCar(solver, call);
+        if (car < 0) continue;
+        int slot = solver.callColumn[call] % solver.numSlots;
+        total += solver.cost[(size_t)call * solver.numCars + car] + slot * solver.slotCost;
+    }
+    return total;
+}
+
+void benchmarkAssignment(int numCars, int numCalls, int runs)
+{
+    const int floors = 100;
+    const float speed = 5.0f;           // Floors per second
+    const float stopTime = 10.0f;       // Door cycle plus acceleration per extra stop
+    int slots = (numCalls + numCars - 1) / numCars;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> position(0.0f, (float)(floors - 1));
+    std::uniform_int_distribution<int> floor(0, floors - 1);
+    std::uniform_int_distribution<int> queued(0, 4);
+
+    double fullMs = 0.0, incrementalMs = 0.0;
+    double optimalCost = 0.0, greedyCost = 0.0;
+    std::vector<float> cost((size_t)numCalls * numCars);
+    AssignmentSolver solver;
+    AssignmentSolver incremental;
+
+    for (int run = 0; run < runs; run++) {
+        // Predicted wait: travel plus the stops already planned for the car
+        std::vector<float> carPosition(numCars);
+        std::vector<int> carStops(numCars);
+        for (int c = 0; c < numCars; c++) {
+            carPosition[c] = position(rng);
+            carStops[c] = queued(rng);
+        }
+        for (int call = 0; call < numCalls; call++) {
+            int f = floor(rng);
+            for (int c = 0; c < numCars; c++) {
+                cost[(size_t)call * numCars + c] = std::abs(carPosition[c] - f) / speed + carStops[c] * stopTime;
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        resetAssignment(solver, numCars, slots, stopTime);
+        solveAssignment(solver, numCalls, cost.data());
+        auto solved = std::chrono::steady_clock::now();
+        optimalCost += totalAssignmentCost(solver);
+
+        // The last ten calls arriving one by one on top of the plan
+        int planned = std::max(0, numCalls - 10);
+        resetAssignment(incremental, numCars, slots, stopTime);
+        solveAssignment(incremental, planned, cost.data());
+        auto addStart = std::chrono::steady_clock::now();
+        for (int call = planned; call < numCalls; call++) addAssignmentCall(incremental, &cost[(size_t)call * numCars]);
+        auto addEnd = std::chrono::steady_clock::now();
+
+        fullMs += std::chrono::duration<double, std::milli>(solved - start).count();
+        incrementalMs += std::chrono::duration<double, std::milli>(addEnd - addStart).count() / std::max(1, numCalls - planned);
+
+        // Greedy: each call in arrival order goes to the car that is cheapest for it right now
+        std::vector<int> used(numCars, 0);
+        for (int call = 0; call < numCalls; call++) {
+            int best = -1;
+            float bestCost = 0.0f;
+            for (int c = 0; c < numCars; c++) {
+                if (used[c] >= slots) continue;
+                float total = cost[(size_t)call * numCars + c] + used[c] * stopTime;
+                if (best < 0 || total < bestCost) {
+                    best = c;
+                    bestCost = total;
+                }
+            }
+            used[best]++;
+            greedyCost += bestCost;
+        }
+    }
+
+    std::cout << numCars << " cars x " << numCalls << " calls (" << slots << " slots per car), " << runs << " runs" << std::endl;
+    std::cout << "Full solve:          " << fullMs / runs << " ms" << std::endl;
+    std::cout << "Incremental call:    " << incrementalMs / runs << " ms" << std::endl;
+    std::cout << "Predicted wait sum:  " << optimalCost / runs << " s optimal, " << greedyCost / runs << " s greedy ("
+              << (greedyCost - optimalCost) / greedyCost * 100.0 << "% saved)" << std::endl;
+}
@@ -0,0 +1,165 @@
+#include "../Header/Building.h"
+
+#include <vector>
+
+static const float PI = 3.14159265359f;
+
+// Unit quads of create3DQuadVAO (facing +Y) and createWallVAO (facing +Z)
+static const float HORIZONTAL_QUAD[] = {
+    -0.5f, 0.0f, -0.5f,   0.0f, 0.0f,    0.0f, 1.0f, 0.0f,
+     0.5f, 0.0f, -0.5f,   1.0f, 0.0f,    0.0f, 1.0f, 0.0f,
+     0.5f, 0.0f,  0.5f,   1.0f, 1.0f,    0.0f, 1.0f, 0.0f,
+    -0.5f, 0.0f,  0.5f,   0.0f, 1.0f,    0.0f, 1.0f, 0.0f
+};
+static const unsigned int HORIZONTAL_QUAD_INDICES[] = { 0, 2, 1, 0, 3, 2 };
+
+static const float VERTICAL_QUAD[] = {
+    -0.5f, -0.5f, 0.0f,   0.0f, 0.0f,    0.0f, 0.0f, 1.0f,
+     0.5f, -0.5f, 0.0f,   1.0f, 0.0f,    0.0f, 0.0f, 1.0f,
+     0.5f,  0.5f, 0.0f,   1.0f, 1.0f,    0.0f, 0.0f, 1.0f,
+    -0.5f,  0.5f, 0.0f,   0.0f, 1.0f,    0.0f, 0.0f, 1.0f
+};
+static const unsigned int VERTICAL_QUAD_INDICES[] = { 0, 1, 2, 2, 3, 0 };
+
+struct GeometryBuilder {
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    DrawRange range;
+    Vec3 centerSum;
+    int quads;
+};
+
+static void beginRange(GeometryBuilder& builder)
+{
+    builder.range.first = (int)builder.indices.size();
+    builder.centerSum = Vec3();
+    builder.quads = 0;
+}
+
+static DrawRange endRange(GeometryBuilder& builder)
+{
+    builder.range.count = (int)builder.indices.size() - builder.range.first;
+    builder.range.center = builder.quads > 0 ? builder.centerSum * (1.0f / builder.quads) : Vec3();
+    return builder.range;
+}
+
+static Vec3 transformPoint(const Mat4& model, float x, float y, float z)
+{
+    const float* m = model.m;
+    return Vec3(m[0]*x + m[4]*y + m[8]*z + m[12],
+                m[1]*x + m[5]*y + m[9]*z + m[13],
+                m[2]*x + m[6]*y + m[10]*z + m[14]);
+}
+
+// The quad normals lie along a scale axis, so the upper 3x3 only rotates them
+// up to length and no inverse transpose is needed
+static void addQuad(GeometryBuilder& builder, bool horizontal, const Mat4& model)
+{
+    const float* quad = horizontal ? HORIZONTAL_QUAD : VERTICAL_QUAD;
+    const unsigned int* quadIndices = horizontal ? HORIZONTAL_QUAD_INDICES : VERTICAL_QUAD_INDICES;
+    unsigned int base = (unsigned int)(builder.vertices.size() / 8);
+
+    for (int v = 0; v < 4; v++) {
+        const float* vertex = quad + v * 8;
+        Vec3 position = transformPoint(model, vertex[0], vertex[1], vertex[2]);
+        Vec3 normal = (transformPoint(model, vertex[5], vertex[6], vertex[7]) -
+                       transformPoint(model, 0.0f, 0.0f, 0.0f)).normalize();
+        float out[8] = {position.x, position.y, position.z, vertex[3], vertex[4], normal.x, normal.y, normal.z};
+        builder.vertices.insert(builder.vertices.end(), out, out + 8);
+    }
+    for (int i = 0; i < 6; i++) builder.indices.push_back(base + quadIndices[i]);
+    builder.centerSum = builder.centerSum + transformPoint(model, 0.0f, 0.0f, 0.0f);
+    builder.quads++;
+}
+
+BuildingGeometry createBuildingGeometry()
+{
+    BuildingGeometry building;
+    GeometryBuilder builder;
+
+    for (int floor = 0; floor < NUM_FLOORS; floor++) {
+        float floorY = floor * FLOOR_HEIGHT;
+
+        beginRange(builder);
+        addQuad(builder, true, Mat4::translate(Vec3(0.0f, floorY, 0.0f)) * Mat4::scale(Vec3(FLOOR_WIDTH, 1.0f, FLOOR_DEPTH)));
+        building.floors[floor] = endRange(builder);
+
+        beginRange(builder);
+        addQuad(builder, true, Mat4::translate(Vec3(0.0f, floorY + FLOOR_HEIGHT, 0.0f)) *
+                               Mat4::rotateX(PI) * Mat4::scale(Vec3(FLOOR_WIDTH, 1.0f, FLOOR_DEPTH)));
+        building.ceilings[floor] = endRange(builder);
+
+        // Back, front, left and right wall
+        beginRange(builder);
+        addQuad(builder, false, Mat4::translate(Vec3(0.0f, floorY + FLOOR_HEIGHT/2, -FLOOR_DEPTH/2)) *
+                                Mat4::scale(Vec3(FLOOR_WIDTH, FLOOR_HEIGHT, 1.0f)));
+        addQuad(builder, false, Mat4::translate(Vec3(0.0f, floorY + FLOOR_HEIGHT/2, FLOOR_DEPTH/2)) *
+                                Mat4::rotateY(PI) * Mat4::scale(Vec3(FLOOR_WIDTH, FLOOR_HEIGHT, 1.0f)));
+        addQuad(builder, false, Mat4::translate(Vec3(-FLOOR_WIDTH/2, floorY + FLOOR_HEIGHT/2, 0.0f)) *
+                                Mat4::rotateY(PI/2) * Mat4::scale(Vec3(FLOOR_DEPTH, FLOOR_HEIGHT, 1.0f)));
+        addQuad(builder, false, Mat4::translate(Vec3(FLOOR_WIDTH/2, floorY + FLOOR_HEIGHT/2, 0.0f)) *
+                                Mat4::rotateY(-PI/2) * Mat4::scale(Vec3(FLOOR_DEPTH, FLOOR_HEIGHT, 1.0f)));
+        building.walls[floor] = endRange(builder);
+    }
+
+    // Cabin standing on y = 0
+    float cabinY = ELEVATOR_SIZE/2;
+    Mat4 cabinWall = Mat4::scale(Vec3(ELEVATOR_SIZE, ELEVATOR_SIZE, 1.0f));
+    Mat4 cabinSlab = Mat4::scale(Vec3(ELEVATOR_SIZE, 1.0f, ELEVATOR_SIZE));
+
+    // Exterior: top, back, left, right - normals pointing outward
+    beginRange(builder);
+    addQuad(builder, true, Mat4::translate(Vec3(ELEVATOR_X, ELEVATOR_SIZE, ELEVATOR_Z)) * Mat4::rotateX(PI) * cabinSlab);
+    addQuad(builder, false, Mat4::translate(Vec3(ELEVATOR_X, cabinY, ELEVATOR_Z - ELEVATOR_SIZE/2)) * Mat4::rotateY(PI) * cabinWall);
+    addQuad(builder, false, Mat4::translate(Vec3(ELEVATOR_X - ELEVATOR_SIZE/2, cabinY, ELEVATOR_Z)) * Mat4::rotateY(-PI/2) * cabinWall);
+    addQuad(builder, false, Mat4::translate(Vec3(ELEVATOR_X + ELEVATOR_SIZE/2, cabinY, ELEVATOR_Z)) * Mat4::rotateY(PI/2) * cabinWall);
+    building.cabinExterior = endRange(builder);
+
+    beginRange(builder);
+    addQuad(builder, false, Mat4::translate(Vec3(ELEVATOR_X, cabinY, ELEVATOR_Z + ELEVATOR_SIZE/2)) * cabinWall);
+    building.cabinExteriorDoor = endRange(builder);
+
+    // Interior: back, left, right, ceiling - normals pointing inward
+    beginRange(builder);
+    addQuad(builder, false, Mat4::translate(Vec3(ELEVATOR_X, cabinY, ELEVATOR_Z - ELEVATOR_SIZE/2)) * cabinWall);
+    addQuad(builder, false, Mat4::translate(Vec3(ELEVATOR_X - ELEVATOR_SIZE/2, cabinY, ELEVATOR_Z)) * Mat4::rotateY(PI/2) * cabinWall);
+    addQuad(builder, false, Mat4::translate(Vec3(ELEVATOR_X + ELEVATOR_SIZE/2, cabinY, ELEVATOR_Z)) * Mat4::rotateY(-PI/2) * cabinWall);
+    addQuad(builder, true, Mat4::translate(Vec3(ELEVATOR_X, ELEVATOR_SIZE, ELEVATOR_Z)) * Mat4::rotateX(PI) * cabinSlab);
+    building.cabinInterior = endRange(builder);
+
+    beginRange(builder);
+    addQuad(builder, false, Mat4::translate(Vec3(ELEVATOR_X, cabinY, ELEVATOR_Z + ELEVATOR_SIZE/2)) * Mat4::rotateY(PI) * cabinWall);
+    building.cabinInteriorDoor = endRange(builder);
+
+    beginRange(builder);
+    addQuad(builder, true, Mat4::translate(Vec3(ELEVATOR_X, 0.0f, ELEVATOR_Z)) * cabinSlab);
+    building.cabinFloor = endRange(builder);
+
+    glGenVertexArrays(1, &building.VAO);
+    glGenBuffers(1, &building.VBO);
+    glGenBuffers(1, &building.EBO);
+
+    glBindVertexArray(building.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, building.VBO);
+    glBufferData(GL_ARRAY_BUFFER, builder.vertices.size() * sizeof(float), builder.vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, building.EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, builder.indices.size() * sizeof(unsigned int), builder.indices.data(), GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(5 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+
+    glBindVertexArray(0);
+    return building;
+}
+
+void deleteBuildingGeometry(BuildingGeometry& building)
+{
+    glDeleteVertexArrays(1, &building.VAO);
+    glDeleteBuffers(1, &building.VBO);
+    glDeleteBuffers(1, &building.EBO);
+    building.VAO = building.VBO = building.EBO = 0;
+}
@@ -0,0 +1,199 @@
+#include "../Header/Elevator.h"
+
+#include <algorithm>
+#include <cmath>
+
+float getFloorYPosition(int floor)
+{
+    return floor * FLOOR_HEIGHT;
+}
+
+int stopFloorFor(const Elevator& elevator, int floor)
+{
+    return elevator.decks > 1 ? floor - floor % 2 : floor;
+}
+
+int deckFor(const Elevator& elevator, int floor)
+{
+    return floor - stopFloorFor(elevator, floor);
+}
+
+bool isAtStopFor(const Elevator& elevator, int floor)
+{
+    return !elevator.moving && floor >= elevator.currentFloor && floor < elevator.currentFloor + elevator.decks;
+}
+
+void addFloorToQueue(Elevator& elevator, int floor)
+{
+    if (floor == elevator.currentFloor && !elevator.moving) {
+        if (!elevator.doorsOpen) {
+            elevator.doorsOpen = true;
+            elevator.doorTimer = 0.0f;
+        }
+        return;
+    }
+
+    if (std::find(elevator.queuedFloors.begin(), elevator.queuedFloors.end(), floor) == elevator.queuedFloors.end()) {
+        elevator.queuedFloors.push_back(floor);
+    }
+}
+
+bool addHallCall(Elevator& elevator, int floor)
+{
+    if (isBypassingHallCalls(elevator)) return false;
+    addFloorToQueue(elevator, floor);
+    return true;
+}
+
+float emptyCarKg(const Elevator& elevator)
+{
+    return CAR_MASS_PER_RATED_KG * elevator.capacityKg * elevator.decks;
+}
+
+float counterweightKg(const Elevator& elevator)
+{
+    return emptyCarKg(elevator) + COUNTERWEIGHT_BALANCE * elevator.capacityKg * elevator.decks;
+}
+
+static float peakSpeed(const Elevator& elevator, float distance)
+{
+    return std::min(elevator.speed, std::sqrt(RATED_ACCELERATION * distance));
+}
+
+// Energy to bring car, load and counterweight up to speed
+static float kineticEnergy(const Elevator& elevator, float loadKg, float speed)
+{
+    float mass = emptyCarKg(elevator) + loadKg + counterweightKg(elevator);
+    return 0.5f * mass * speed * speed;
+}
+
+// Work against gravity for a climb of dy (negative going down) - the counterweight drops as the car rises
+static float liftWork(const Elevator& elevator, float loadKg, float dy)
+{
+    return (emptyCarKg(elevator) + loadKg - counterweightKg(elevator)) * GRAVITY * dy;
+}
+
+static float driveEnergy(float work)
+{
+    return work > 0.0f ? work / DRIVE_EFFICIENCY : work * REGEN_EFFICIENCY;
+}
+
+float runEnergy(const Elevator& elevator, float fromY, float toY, float loadKg)
+{
+    float kinetic = kineticEnergy(elevator, loadKg, peakSpeed(elevator, std::abs(toY - fromY)));
+    return driveEnergy(liftWork(elevator, loadKg, toY - fromY)) +
+           kinetic / DRIVE_EFFICIENCY - kinetic * REGEN_EFFICIENCY + DOOR_CYCLE_ENERGY_J;
+}
+
+static void addEnergy(Elevator& elevator, float energy)
+{
+    if (energy > 0.0f) elevator.energyUsedJ += energy;
+    else elevator.energyRecoveredJ -= energy;
+}
+
+void startRun(Elevator& elevator, int floor)
+{
+    float targetY = getFloorYPosition(floor);
+    float speed = peakSpeed(elevator, std::abs(targetY - elevator.y));
+    float kinetic = kineticEnergy(elevator, elevator.loadKg, speed);
+
+    // A moving car speeds up or slows down to the new run's peak - or brakes
+    // to a stop first if the new floor is behind it
+    if (elevator.moving) {
+        float current = kineticEnergy(elevator, elevator.loadKg, elevator.runSpeed);
+        float oldY = getFloorYPosition(elevator.targetFloor);
+        if ((targetY - elevator.y) * (oldY - elevator.y) > 0.0f) kinetic -= current;
+        else elevator.energyRecoveredJ += current * REGEN_EFFICIENCY;
+    }
+    addEnergy(elevator, driveEnergy(kinetic));
+
+    elevator.targetFloor = floor;
+    elevator.moving = true;
+    elevator.runSpeed = speed;
+}
+
+bool stepElevator(Elevator& elevator, float deltaTime)
+{
+    elevator.energyUsedJ += STANDBY_POWER_W * deltaTime;
+
+    // Door timer - runs whenever doors are open
+    if (elevator.doorsOpen) {
+        elevator.doorTimer += deltaTime;
+
+        float doorOpenTime = elevator.doorExtendUsed ? elevator.doorExtendedTime : elevator.doorOpenTime;
+
+        if (elevator.doorTimer >= doorOpenTime) {
+            elevator.doorsOpen = false;
+            elevator.doorTimer = 0.0f;
+            elevator.doorExtendUsed = false;
+        }
+    }
+
+    // Start moving to next floor in queue
+    if (!elevator.queuedFloors.empty() && !elevator.moving && !elevator.doorsOpen) {
+        int floor = elevator.queuedFloors[0];
+        elevator.queuedFloors.erase(elevator.queuedFloors.begin());
+        startRun(elevator, floor);
+    }
+
+    if (!elevator.moving || elevator.doorsOpen) return false;
+
+    float targetY = getFloorYPosition(elevator.targetFloor);
+    float direction = (targetY > elevator.y) ? 1.0f : -1.0f;
+    float step = elevator.speed * deltaTime;
+    float startY = elevator.y;
+    elevator.y += direction * step;
+
+    // Reached target floor (tolerance grows with the step so large time steps cannot overshoot)
+    bool arrived = std::abs(elevator.y - targetY) < std::max(0.1f, step);
+    if (arrived) elevator.y = targetY;
+    addEnergy(elevator, driveEnergy(liftWork(elevator, elevator.loadKg, elevator.y - startY)));
+
+    if (arrived) {
+        elevator.energyRecoveredJ += kineticEnergy(elevator, elevator.loadKg, elevator.runSpeed) * REGEN_EFFICIENCY;
+        elevator.energyUsedJ += DOOR_CYCLE_ENERGY_J;
+        elevator.currentFloor = elevator.targetFloor;
+        elevator.moving = false;
+        elevator.doorsOpen = true;           // Open doors when arriving
+        elevator.doorTimer = 0.0f;           // Reset timer
+        elevator.doorExtendUsed = false;     // Reset extension flag
+        return true;
+    }
+    return false;
+}
+
+float getLoadFactor(const Elevator& elevator)
+{
+    float factor = 0.0f;
+    for (int deck = 0; deck < elevator.decks; deck++) {
+        float byPersons = elevator.capacityPersons > 0 ? (float)elevator.deckPassengers[deck] / elevator.capacityPersons : 1.0f;
+        float byWeight = elevator.capacityKg > 0.0f ? elevator.deckLoadKg[deck] / elevator.capacityKg : 1.0f;
+        factor = std::max(factor, std::max(byPersons, byWeight));
+    }
+    return factor;
+}
+
+bool isBypassingHallCalls(const Elevator& elevator)
+{
+    return getLoadFactor(elevator) > HALL_CALL_BYPASS_LOAD;
+}
+
+bool boardElevator(Elevator& elevator, float weightKg, int deck)
+{
+    if (elevator.deckPassengers[deck] + 1 > elevator.capacityPersons) return false;
+    if (elevator.deckLoadKg[deck] + weightKg > elevator.capacityKg) return false;
+
+    elevator.deckPassengers[deck]++;
+    elevator.deckLoadKg[deck] += weightKg;
+    elevator.passengerCount++;
+    elevator.loadKg += weightKg;
+    return true;
+}
+
+void alightElevator(Elevator& elevator, float weightKg, int deck)
+{
+    elevator.deckPassengers[deck] = std::max(0, elevator.deckPassengers[deck] - 1);
+    elevator.deckLoadKg[deck] = std::max(0.0f, elevator.deckLoadKg[deck] - weightKg);
+    elevator.passengerCount = std::max(0, elevator.passengerCount - 1);
+    elevator.loadKg = std::max(0.0f, elevator.loadKg - weightKg);
+}
@@ -0,0 +1,200 @@
+#include "../Header/EtaTable.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Stops still ahead of the car: the target while moving, then the queue
+static int routeLength(const Elevator& car)
+{
+    return (car.moving ? 1 : 0) + (int)car.queuedFloors.size();
+}
+
+static int routeStop(const Elevator& car, int i)
+{
+    if (car.moving) return i == 0 ? car.targetFloor : car.queuedFloors[i - 1];
+    return car.queuedFloors[i];
+}
+
+static void pushStop(EtaTable& table, const Elevator& car, int floor, float now)
+{
+    // An idle car leaves when the stop is added, not when it went idle
+    if (table.head == (int)table.route.size() && table.freeTime + table.offset < now) {
+        table.freeTime = now - table.offset;
+    }
+
+    float y = getFloorYPosition(floor);
+    float arrival = table.freeTime + std::abs(y - table.freeY) / car.speed;
+    if (table.floorStop[floor] < 0) table.floorStop[floor] = (int)table.route.size();
+    table.route.push_back(floor);
+    table.arrival.push_back(arrival);
+    table.dwellBefore.push_back(table.freeDwell);
+
+    table.freeTime = arrival + car.doorOpenTime;
+    table.freeY = y;
+    table.freeDwell += car.doorOpenTime;
+    table.entriesComputed++;
+}
+
+// Recomputes the route from absolute index "from" on; from == head starts over from the car's state
+static void rebuildFrom(EtaTable& table, const Elevator& car, int from, float now)
+{
+    for (int k = from; k < (int)table.route.size(); k++) {
+        if (table.floorStop[table.route[k]] >= from) table.floorStop[table.route[k]] = -1;
+    }
+
+    int first;
+    if (from == table.head) {
+        table.route.clear();
+        table.arrival.clear();
+        table.dwellBefore.clear();
+        table.head = 0;
+        table.offset = 0.0f;
+        table.dwellDone = 0.0f;
+
+        float remaining = 0.0f;
+        if (car.doorsOpen) {
+            float doorOpenTime = car.doorExtendUsed ? car.doorExtendedTime : car.doorOpenTime;
+            remaining = std::max(0.0f, doorOpenTime - car.doorTimer);
+        }
+        table.freeTime = now + remaining;
+        table.freeY = car.y;
+        table.freeDwell = remaining;
+        first = 0;
+    } else {
+        table.route.resize(from);
+        table.arrival.resize(from);
+        table.dwellBefore.resize(from);
+        table.freeTime = table.arrival[from - 1] + car.doorOpenTime;
+        table.freeY = getFloorYPosition(table.route[from - 1]);
+        table.freeDwell = table.dwellBefore[from - 1] + car.doorOpenTime;
+        first = from - table.head;
+    }
+
+    for (int i = first; i < routeLength(car); i++) pushStop(table, car, routeStop(car, i), now);
+}
+
+void initEtaTable(EtaTable& table, const Elevator& car, int numFloors, float now)
+{
+    table.route.clear();
+    table.arrival.clear();
+    table.dwellBefore.clear();
+    table.floorStop.assign(numFloors, -1);
+    table.head = 0;
+    table.entriesComputed = 0;
+    rebuildFrom(table, car, 0, now);
+
+    table.syncTime = now;
+    table.speed = car.speed;
+    table.moving = car.moving;
+    table.doorsOpen = car.doorsOpen;
+    table.doorExtendUsed = car.doorExtendUsed;
+}
+
+// The car has reached the front stop
+static void popStop(EtaTable& table)
+{
+    int floor = table.route[table.head];
+    table.dwellDone = table.dwellBefore[table.head] + table.offset;
+    if (table.floorStop[floor] == table.head) {
+        table.floorStop[floor] = -1;
+        for (int k = table.head + 1; k < (int)table.route.size(); k++) {
+            if (table.route[k] == floor) {
+                table.floorStop[floor] = k;
+                break;
+            }
+        }
+    }
+    table.head++;
+
+    // A busy car may never empty its route - drop the passed stops once they outnumber the rest
+    int size = (int)table.route.size();
+    if (table.head == size || (table.head >= ETA_COMPACT_STOPS && table.head * 2 >= size)) {
+        for (int k = table.head; k < size; k++) {
+            if (table.floorStop[table.route[k]] == k) table.floorStop[table.route[k]] = k - table.head;
+        }
+        table.route.erase(table.route.begin(), table.route.begin() + table.head);
+        table.arrival.erase(table.arrival.begin(), table.arrival.begin() + table.head);
+        table.dwellBefore.erase(table.dwellBefore.begin(), table.dwellBefore.begin() + table.head);
+        table.head = 0;
+    }
+}
+
+static void syncRoute(EtaTable& table, const Elevator& car, float now)
+{
+    float deltaTime = now - table.syncTime;
+    int cached = (int)table.route.size() - table.head;
+
+    // Every entry was timed at the old speed
+    if (car.speed != table.speed) {
+        rebuildFrom(table, car, table.head, now);
+        return;
+    }
+
+    if (table.moving && !car.moving) {
+        bool expected = cached > 0 && table.route[table.head] == car.currentFloor &&
+                        std::abs(now - (table.arrival[table.head] + table.offset)) <= ETA_DRIFT_TOLERANCE;
+        if (!expected) {
+            rebuildFrom(table, car, table.head, now);
+            return;
+        }
+        // Small misses (time step, rounding) carry over to the later stops
+        table.offset += now - (table.arrival[table.head] + table.offset);
+        popStop(table);
+        cached--;
+    } else if (!table.doorsOpen && car.doorsOpen && !car.moving) {
+        // Doors reopened for a call at the car's own floor - the dwell starts over
+        rebuildFrom(table, car, table.head, now);
+        return;
+    } else if (cached > 0 && !car.moving && !car.doorsOpen) {
+        // Ready to leave but held in the shaft
+        table.offset += deltaTime;
+    }
+
+    if (car.doorsOpen && car.doorExtendUsed && !table.doorExtendUsed) {
+        table.offset += car.doorExtendedTime - car.doorOpenTime;
+    }
+
+    // The queue only grows at the back, shrinks at the front or gets reordered
+    // by the shaft, so comparing the ends tells the common cases apart
+    int length = routeLength(car);
+    bool sameFront = cached == 0 || (length > 0 && table.route[table.head] == routeStop(car, 0));
+    if (length == cached && sameFront && (cached == 0 || table.route.back() == routeStop(car, length - 1))) return;
+    if (length == cached + 1 && sameFront && (cached == 0 || table.route.back() == routeStop(car, length - 2))) {
+        pushStop(table, car, routeStop(car, length - 1), now);
+        return;
+    }
+
+    int i = 0;
+    while (i < cached && i < length && table.route[table.head + i] == routeStop(car, i)) i++;
+    rebuildFrom(table, car, table.head + i, now);
+}
+
+void syncEtaTable(EtaTable& table, const Elevator& car, float now)
+{
+    syncRoute(table, car, now);
+    table.syncTime = now;
+    table.speed = car.speed;
+    table.moving = car.moving;
+    table.doorsOpen = car.doorsOpen;
+    table.doorExtendUsed = car.doorExtendUsed;
+}
+
+Eta estimateArrival(const EtaTable& table, const Elevator& car, int floor, float now)
+{
+    if (!car.moving && car.currentFloor == floor) return {0.0f, 0.0f};    // Doors open for the call right away
+
+    float arrival, dwell;
+    int k = table.floorStop[floor];
+    if (k >= 0) {
+        arrival = table.arrival[k] + table.offset;
+        dwell = table.dwellBefore[k] + table.offset - table.dwellDone;
+    } else {
+        float leave = std::max(now, table.freeTime + table.offset);
+        arrival = leave + std::abs(getFloorYPosition(floor) - table.freeY) / car.speed;
+        dwell = table.freeDwell + table.offset - table.dwellDone;
+    }
+
+    float wait = std::max(0.0f, arrival - now);
+    dwell = std::min(wait, std::max(0.0f, dwell));
+    return {wait - dwell, dwell};
+}
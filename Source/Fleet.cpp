@@ -0,0 +1,286 @@
+#include "../Header/Fleet.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FLEET_SSE 1
+#endif
+
+const std::uint32_t LANE_TRUE = 0xFFFFFFFFu;
+
+// Pointer into "storage" at the next FLEET_ALIGNMENT boundary
+template <typename T>
+static T* alignedLanes(std::vector<T>& storage, size_t offset)
+{
+    size_t misalignment = reinterpret_cast<std::uintptr_t>(storage.data()) % FLEET_ALIGNMENT;
+    size_t skip = misalignment ? (FLEET_ALIGNMENT - misalignment) / sizeof(T) : 0;
+    return storage.data() + skip + offset;
+}
+
+void initFleet(Fleet& fleet, int count)
+{
+    const int floatArrays = 6, maskArrays = 3;
+    int lanes = (count + FLEET_BATCH - 1) / FLEET_BATCH * FLEET_BATCH;
+    size_t slack = FLEET_ALIGNMENT / sizeof(float);
+
+    fleet.count = count;
+    fleet.lanes = lanes;
+    fleet.floatStorage.assign((size_t)floatArrays * lanes + slack, 0.0f);
+    fleet.maskStorage.assign((size_t)maskArrays * lanes + slack, 0u);
+    fleet.y = alignedLanes(fleet.floatStorage, 0);
+    fleet.targetY = alignedLanes(fleet.floatStorage, lanes);
+    fleet.speed = alignedLanes(fleet.floatStorage, 2 * (size_t)lanes);
+    fleet.doorTimer = alignedLanes(fleet.floatStorage, 3 * (size_t)lanes);
+    fleet.doorDwell = alignedLanes(fleet.floatStorage, 4 * (size_t)lanes);
+    fleet.doorOpenTime = alignedLanes(fleet.floatStorage, 5 * (size_t)lanes);
+    fleet.moving = alignedLanes(fleet.maskStorage, 0);
+    fleet.doorsOpen = alignedLanes(fleet.maskStorage, lanes);
+    fleet.pending = alignedLanes(fleet.maskStorage, 2 * (size_t)lanes);
+
+    fleet.currentFloor.assign(count, 0);
+    fleet.targetFloor.assign(count, 0);
+    fleet.queues.assign(count, std::vector<int>());
+    fleet.arrivals = 0;
+    for (int i = 0; i < lanes; i++) fleet.doorDwell[i] = fleet.doorOpenTime[i] = DOOR_OPEN_TIME;
+}
+
+void loadFleet(Fleet& fleet, const std::vector<Elevator>& cars)
+{
+    initFleet(fleet, (int)cars.size());
+    for (int i = 0; i < fleet.count; i++) {
+        const Elevator& car = cars[i];
+        fleet.y[i] = car.y;
+        fleet.targetY[i] = getFloorYPosition(car.targetFloor);
+        fleet.speed[i] = car.speed;
+        fleet.doorTimer[i] = car.doorTimer;
+        fleet.doorOpenTime[i] = car.doorOpenTime;
+        fleet.doorDwell[i] = car.doorExtendUsed ? car.doorExtendedTime : car.doorOpenTime;
+        fleet.moving[i] = car.moving ? LANE_TRUE : 0u;
+        fleet.doorsOpen[i] = car.doorsOpen ? LANE_TRUE : 0u;
+        fleet.pending[i] = car.queuedFloors.empty() ? 0u : LANE_TRUE;
+        fleet.currentFloor[i] = car.currentFloor;
+        fleet.targetFloor[i] = car.targetFloor;
+        fleet.queues[i] = car.queuedFloors;
+    }
+}
+
+void storeFleet(const Fleet& fleet, std::vector<Elevator>& cars)
+{
+    for (int i = 0; i < fleet.count && i < (int)cars.size(); i++) {
+        Elevator& car = cars[i];
+        car.y = fleet.y[i];
+        car.speed = fleet.speed[i];
+        car.doorTimer = fleet.doorTimer[i];
+        car.moving = fleet.moving[i] != 0u;
+        car.doorsOpen = fleet.doorsOpen[i] != 0u;
+        car.currentFloor = fleet.currentFloor[i];
+        car.targetFloor = fleet.targetFloor[i];
+        car.queuedFloors = fleet.queues[i];
+    }
+}
+
+void addFleetStop(Fleet& fleet, int car, int floor)
+{
+    if (floor == fleet.currentFloor[car] && !fleet.moving[car]) {
+        if (!fleet.doorsOpen[car]) {
+            fleet.doorsOpen[car] = LANE_TRUE;
+            fleet.doorTimer[car] = 0.0f;
+            fleet.doorDwell[car] = fleet.doorOpenTime[car];
+        }
+        return;
+    }
+
+    std::vector<int>& queue = fleet.queues[car];
+    if (std::find(queue.begin(), queue.end(), floor) == queue.end()) queue.push_back(floor);
+    fleet.pending[car] = LANE_TRUE;
+}
+
+static void startNextStop(Fleet& fleet, int car)
+{
+    std::vector<int>& queue = fleet.queues[car];
+    fleet.targetFloor[car] = queue.front();
+    fleet.targetY[car] = getFloorYPosition(queue.front());
+    queue.erase(queue.begin());
+    fleet.moving[car] = LANE_TRUE;
+    fleet.pending[car] = queue.empty() ? 0u : LANE_TRUE;
+}
+
+static void arrive(Fleet& fleet, int car)
+{
+    fleet.currentFloor[car] = fleet.targetFloor[car];
+    fleet.arrivals++;
+}
+
+void stepFleetScalar(Fleet& fleet, float deltaTime)
+{
+    for (int i = 0; i < fleet.count; i++) {
+        if (fleet.doorsOpen[i]) {
+            fleet.doorTimer[i] += deltaTime;
+            if (fleet.doorTimer[i] >= fleet.doorDwell[i]) {
+                fleet.doorsOpen[i] = 0u;
+                fleet.doorTimer[i] = 0.0f;
+            }
+        }
+        if (fleet.pending[i] && !fleet.moving[i] && !fleet.doorsOpen[i]) startNextStop(fleet, i);
+        if (!fleet.moving[i] || fleet.doorsOpen[i]) continue;
+
+        float direction = fleet.targetY[i] - fleet.y[i] < 0.0f ? -1.0f : 1.0f;
+        float step = fleet.speed[i] * deltaTime;
+        float y = fleet.y[i] + direction * step;
+        if (std::abs(y - fleet.targetY[i]) < std::max(0.1f, step)) {
+            y = fleet.targetY[i];
+            fleet.moving[i] = 0u;
+            fleet.doorsOpen[i] = LANE_TRUE;
+            fleet.doorTimer[i] = 0.0f;
+            fleet.doorDwell[i] = fleet.doorOpenTime[i];
+            arrive(fleet, i);
+        }
+        fleet.y[i] = y;
+    }
+}
+
+#ifdef FLEET_SSE
+static inline __m128 loadMask(const std::uint32_t* lanes)
+{
+    return _mm_castsi128_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(lanes)));
+}
+
+static inline void storeMask(std::uint32_t* lanes, __m128 mask)
+{
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), _mm_castps_si128(mask));
+}
+
+static inline __m128 select(__m128 mask, __m128 whenTrue, __m128 whenFalse)
+{
+    return _mm_or_ps(_mm_and_ps(mask, whenTrue), _mm_andnot_ps(mask, whenFalse));
+}
+
+void stepFleet(Fleet& fleet, float deltaTime)
+{
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minTolerance = _mm_set1_ps(0.1f);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+
+    for (int i = 0; i < fleet.lanes; i += FLEET_BATCH) {
+        // Doors: tick the timer of open lanes, close those past their dwell
+        __m128 open = loadMask(fleet.doorsOpen + i);
+        __m128 timer = _mm_add_ps(_mm_load_ps(fleet.doorTimer + i), _mm_and_ps(open, dt));
+        __m128 closing = _mm_and_ps(open, _mm_cmpge_ps(timer, _mm_load_ps(fleet.doorDwell + i)));
+        open = _mm_andnot_ps(closing, open);
+        timer = _mm_andnot_ps(closing, timer);
+
+        // Idle lanes with work leave for their next stop - queue access is scalar
+        __m128 moving = loadMask(fleet.moving + i);
+        int ready = _mm_movemask_ps(_mm_andnot_ps(_mm_or_ps(moving, open), loadMask(fleet.pending + i)));
+        if (ready) {
+            for (int lane = 0; lane < FLEET_BATCH; lane++) {
+                if (ready & (1 << lane)) startNextStop(fleet, i + lane);
+            }
+            moving = loadMask(fleet.moving + i);
+        }
+
+        // Motion: advance active lanes, snap the ones within a step of the target
+        __m128 y = _mm_load_ps(fleet.y + i);
+        __m128 target = _mm_load_ps(fleet.targetY + i);
+        __m128 active = _mm_andnot_ps(open, moving);
+        __m128 direction = _mm_or_ps(_mm_and_ps(signBit, _mm_sub_ps(target, y)), one);
+        __m128 step = _mm_mul_ps(_mm_load_ps(fleet.speed + i), dt);
+        __m128 next = _mm_add_ps(y, _mm_mul_ps(direction, step));
+        __m128 distance = _mm_andnot_ps(signBit, _mm_sub_ps(next, target));
+        __m128 arrived = _mm_and_ps(active, _mm_cmplt_ps(distance, _mm_max_ps(minTolerance, step)));
+        next = select(arrived, target, next);
+
+        _mm_store_ps(fleet.y + i, select(active, next, y));
+        storeMask(fleet.moving + i, _mm_andnot_ps(arrived, moving));
+        storeMask(fleet.doorsOpen + i, _mm_or_ps(open, arrived));
+        _mm_store_ps(fleet.doorTimer + i, _mm_andnot_ps(arrived, timer));
+        _mm_store_ps(fleet.doorDwell + i, select(arrived, _mm_load_ps(fleet.doorOpenTime + i), _mm_load_ps(fleet.doorDwell + i)));
+
+        int arrivals = _mm_movemask_ps(arrived);
+        if (arrivals) {
+            for (int lane = 0; lane < FLEET_BATCH; lane++) {
+                if (arrivals & (1 << lane)) arrive(fleet, i + lane);
+            }
+        }
+    }
+}
+#else
+void stepFleet(Fleet& fleet, float deltaTime)
+{
+    stepFleetScalar(fleet, deltaTime);
+}
+#endif
+
+// Every car gets a random stop whenever its queue runs dry - same sequence for every fleet
+static void refillStops(Fleet& fleet, std::mt19937& rng, int floors)
+{
+    std::uniform_int_distribution<int> floor(0, floors - 1);
+    for (int i = 0; i < fleet.count; i++) {
+        if (!fleet.pending[i] && !fleet.moving[i]) addFleetStop(fleet, i, floor(rng));
+    }
+}
+
+void benchmarkFleet(int numCars, int steps)
+{
+    const int floors = 40;
+    const float deltaTime = 1.0f / 60.0f;
+    const int refillEvery = 32;
+
+    std::vector<Elevator> cars(numCars);
+    std::mt19937 placement(11);
+    std::uniform_int_distribution<int> anyFloor(0, floors - 1);
+    for (Elevator& car : cars) {
+        car = {0.0f, 0, 0, false, false, 0.0f, 3.0f, false, {}};
+        car.currentFloor = car.targetFloor = anyFloor(placement);
+        car.y = getFloorYPosition(car.currentFloor);
+    }
+
+    Fleet simd, scalar;
+    loadFleet(simd, cars);
+    loadFleet(scalar, cars);
+    std::mt19937 simdRng(5), scalarRng(5);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; s++) {
+        if (s % refillEvery == 0) refillStops(simd, simdRng, floors);
+        stepFleet(simd, deltaTime);
+    }
+    double simdSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; s++) {
+        if (s % refillEvery == 0) refillStops(scalar, scalarRng, floors);
+        stepFleetScalar(scalar, deltaTime);
+    }
+    double scalarSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // stepElevator on the same cars, with random stops the same way
+    std::mt19937 carRng(5);
+    start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; s++) {
+        if (s % refillEvery == 0) {
+            for (Elevator& car : cars) {
+                if (car.queuedFloors.empty() && !car.moving) addFloorToQueue(car, anyFloor(carRng));
+            }
+        }
+        for (Elevator& car : cars) stepElevator(car, deltaTime);
+    }
+    double carSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    float maxDifference = 0.0f;
+    for (int i = 0; i < numCars; i++) maxDifference = std::max(maxDifference, std::abs(simd.y[i] - scalar.y[i]));
+
+    double carSteps = (double)numCars * steps;
+    std::cout << numCars << " cars x " << steps << " steps, " << simd.arrivals << " arrivals" << std::endl;
+    std::cout << "SSE fleet:     " << carSteps / simdSeconds / 1e6 << " M car-steps/s" << std::endl;
+    std::cout << "Scalar fleet:  " << carSteps / scalarSeconds / 1e6 << " M car-steps/s" << std::endl;
+    std::cout << "stepElevator:  " << carSteps / carSeconds / 1e6 << " M car-steps/s" << std::endl;
+    std::cout << "SSE vs scalar: " << maxDifference << " m largest position difference, "
+              << (simd.arrivals == scalar.arrivals ? "same" : "different") << " arrivals" << std::endl;
+}
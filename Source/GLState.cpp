@@ -0,0 +1,111 @@
+#include "../Header/GLState.h"
+
+#include <iostream>
+
+GLStateCache glState = {};
+
+static const char* GL_STATE_NAMES[GL_STATE_KINDS] = {
+    "program", "vertex array", "active texture", "texture", "blend", "depth test", "cull face"
+};
+
+void resetGLState()
+{
+    glState.program = ~0u;
+    glState.vertexArray = ~0u;
+    glState.activeTexture = ~0u;
+    for (int i = 0; i < GL_STATE_TEXTURE_UNITS; i++) {
+        glState.textures[i] = ~0u;
+        glState.textureArrays[i] = ~0u;
+    }
+    glState.blend = -1;
+    glState.depthTest = -1;
+    glState.cullFace = -1;
+}
+
+// True if the value changed and the GL call has to be made
+static bool changeState(unsigned int& current, unsigned int value, GLStateKind kind)
+{
+    if (current == value) {
+        glState.skipped[kind]++;
+        return false;
+    }
+    current = value;
+    glState.issued[kind]++;
+    return true;
+}
+
+static void setCapability(int& current, bool enabled, GLenum capability, GLStateKind kind)
+{
+    if (current == (int)enabled) {
+        glState.skipped[kind]++;
+        return;
+    }
+    current = enabled;
+    glState.issued[kind]++;
+    if (enabled) glEnable(capability);
+    else glDisable(capability);
+}
+
+void useProgram(unsigned int program)
+{
+    if (changeState(glState.program, program, GL_STATE_PROGRAM)) glUseProgram(program);
+}
+
+void bindVertexArray(unsigned int vertexArray)
+{
+    if (changeState(glState.vertexArray, vertexArray, GL_STATE_VERTEX_ARRAY)) glBindVertexArray(vertexArray);
+}
+
+static void bindTexture(unsigned int& current, unsigned int unit, GLenum target, unsigned int texture)
+{
+    // The active unit only matters if the binding itself changes
+    if (current == texture) {
+        glState.skipped[GL_STATE_TEXTURE]++;
+        return;
+    }
+    if (changeState(glState.activeTexture, unit, GL_STATE_ACTIVE_TEXTURE)) glActiveTexture(GL_TEXTURE0 + unit);
+    changeState(current, texture, GL_STATE_TEXTURE);
+    glBindTexture(target, texture);
+}
+
+void bindTexture2D(unsigned int unit, unsigned int texture)
+{
+    bindTexture(glState.textures[unit], unit, GL_TEXTURE_2D, texture);
+}
+
+void bindTextureArray(unsigned int unit, unsigned int texture)
+{
+    bindTexture(glState.textureArrays[unit], unit, GL_TEXTURE_2D_ARRAY, texture);
+}
+
+void setBlend(bool enabled)
+{
+    setCapability(glState.blend, enabled, GL_BLEND, GL_STATE_BLEND);
+}
+
+void setDepthTest(bool enabled)
+{
+    setCapability(glState.depthTest, enabled, GL_DEPTH_TEST, GL_STATE_DEPTH_TEST);
+}
+
+void setCullFace(bool enabled)
+{
+    setCapability(glState.cullFace, enabled, GL_CULL_FACE, GL_STATE_CULL_FACE);
+}
+
+void printGLStateStats(long long frames)
+{
+    long long issued = 0, skipped = 0;
+    for (int i = 0; i < GL_STATE_KINDS; i++) {
+        issued += glState.issued[i];
+        skipped += glState.skipped[i];
+    }
+    if (frames < 1) frames = 1;
+    std::cout << "GL state changes over " << frames << " frames: " << (double)issued / frames
+              << " issued, " << (double)skipped / frames << " skipped per frame" << std::endl;
+    for (int i = 0; i < GL_STATE_KINDS; i++) {
+        if (glState.issued[i] + glState.skipped[i] == 0) continue;
+        std::cout << "  " << GL_STATE_NAMES[i] << ": " << (double)glState.issued[i] / frames << " issued, "
+                  << (double)glState.skipped[i] / frames << " skipped" << std::endl;
+    }
+}
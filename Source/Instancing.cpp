@@ -0,0 +1,116 @@
+#include "../Header/Instancing.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+void createInstanceBatch(InstanceBatch& batch, unsigned int vertexArray, int count, bool indexed)
+{
+    batch.vertexArray = vertexArray;
+    batch.capacity = 0;
+    batch.indexed = indexed;
+    batch.count = count;
+    batch.instances.clear();
+
+    glGenBuffers(1, &batch.buffer);
+    glBindVertexArray(vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, batch.buffer);
+    for (int column = 0; column < 4; column++) {
+        int location = INSTANCE_ATTRIBUTE_MODEL + column;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                              (void*)(offsetof(InstanceData, model) + column * 4 * sizeof(float)));
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+    glVertexAttribPointer(INSTANCE_ATTRIBUTE_AMBIENT, 1, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                          (void*)offsetof(InstanceData, ambient));
+    glEnableVertexAttribArray(INSTANCE_ATTRIBUTE_AMBIENT);
+    glVertexAttribDivisor(INSTANCE_ATTRIBUTE_AMBIENT, 1);
+    glVertexAttribIPointer(INSTANCE_ATTRIBUTE_MATERIAL, 1, GL_INT, sizeof(InstanceData),
+                           (void*)offsetof(InstanceData, material));
+    glEnableVertexAttribArray(INSTANCE_ATTRIBUTE_MATERIAL);
+    glVertexAttribDivisor(INSTANCE_ATTRIBUTE_MATERIAL, 1);
+    glBindVertexArray(0);
+}
+
+void deleteInstanceBatch(InstanceBatch& batch)
+{
+    glDeleteBuffers(1, &batch.buffer);
+    batch.buffer = 0;
+    batch.instances.clear();
+}
+
+void addInstance(InstanceBatch& batch, const Mat4& model, float ambient, int material)
+{
+    InstanceData instance;
+    memcpy(instance.model, model.m, sizeof(instance.model));
+    instance.ambient = ambient;
+    instance.material = material;
+    batch.instances.push_back(instance);
+}
+
+void uploadInstances(InstanceBatch& batch)
+{
+    int instances = (int)batch.instances.size();
+    glBindBuffer(GL_ARRAY_BUFFER, batch.buffer);
+    if (instances > batch.capacity) {
+        batch.capacity = instances;
+        glBufferData(GL_ARRAY_BUFFER, instances * sizeof(InstanceData), batch.instances.data(), GL_STREAM_DRAW);
+    } else {
+        // Orphan last frame's store before refilling it
+        glBufferData(GL_ARRAY_BUFFER, batch.capacity * sizeof(InstanceData), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instances * sizeof(InstanceData), batch.instances.data());
+    }
+}
+
+void drawInstanceBatch(InstanceBatch& batch)
+{
+    int instances = (int)batch.instances.size();
+    if (instances == 0) return;
+
+    uploadInstances(batch);
+    if (batch.indexed) glDrawElementsInstanced(GL_TRIANGLES, batch.count, GL_UNSIGNED_INT, 0, instances);
+    else glDrawArraysInstanced(GL_TRIANGLES, 0, batch.count, instances);
+}
+
+unsigned int createTextureArray(const std::vector<unsigned int>& textures, int size)
+{
+    int layers = std::max(1, (int)textures.size());
+    unsigned int array;
+    glGenTextures(1, &array);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, size, size, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    unsigned int framebuffers[2];
+    glGenFramebuffers(2, framebuffers);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[0]);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[1]);
+    const float transparent[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < layers; i++) {
+        glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, array, 0, i);
+        if (i >= (int)textures.size() || textures[i] == 0) {
+            glClearBufferfv(GL_COLOR, 0, transparent);
+            continue;
+        }
+
+        int width = 0, height = 0;
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[i], 0);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, size, size, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(2, framebuffers);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    return array;
+}
@@ -6,24 +6,33 @@
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <cstdio>
 #include "../Header/Util.h"
+#include "../Header/Shader.h"
+#include "../Header/GLState.h"
+#include "../Header/RenderQueue.h"
+#include "../Header/Building.h"
+#include "../Header/Elevator.h"
+#include "../Header/Simulation.h"
+#include "../Header/Sweep.h"
+#include "../Header/Optimizer.h"
+#include "../Header/Fleet.h"
+#include "../Header/Agents.h"
+#include "../Header/Scenario.h"
+#include "../Header/Trace.h"
+#include "../Header/Transform.h"
 
 const int WINDOW_WIDTH = 1280;
 const int WINDOW_HEIGHT = 720;
 const float TARGET_FPS = 75.0f;
 const float FRAME_TIME = 1.0f / TARGET_FPS;
 const float PI = 3.14159265359f;
+const int MAX_WAITING_SHOWN = 40;       // Figures on a replayed landing, 8 to a row
 
-// Floor dimensions in 3D world
-const float FLOOR_HEIGHT = 6.0f;      // Height of each floor
-const float FLOOR_WIDTH = 20.0f;      // Width of the building
-const float FLOOR_DEPTH = 16.0f;      // Depth of each floor
-const float ELEVATOR_SIZE = 3.9f;     // Elevator cabin size
-const int NUM_FLOORS = 8;
-
-// Elevator position - in back-right corner
-const float ELEVATOR_X = FLOOR_WIDTH/2 - ELEVATOR_SIZE/2;   // Right side
-const float ELEVATOR_Z = -FLOOR_DEPTH/2 + ELEVATOR_SIZE/2;  // Back side
+// Floor and cabin dimensions live in Building.h
 
 struct Camera {
     Vec3 position;
@@ -54,28 +63,30 @@ struct Camera {
 struct Button3D {
     Vec3 position;      // Local position relative to elevator (on left wall)
     float width, height;
-    unsigned int texture;
+    int material;       // Layer of the button texture array
     int floorNumber;
     bool isPressed;
 };
 
-struct Elevator {
-    float y;                    // Current Y position (world coords)
-    int currentFloor;
-    int targetFloor;
-    bool moving;
-    bool doorsOpen;
-    float doorTimer;
-    float speed;
-    bool doorExtendUsed;
-    std::vector<int> queuedFloors;
-};
-
 struct Person {
     Vec3 position;
     bool inElevator;
     int currentFloor;
     float speed;
+    float weightKg;
+    int deck;           // Cabin of a double-deck car the person rides in
+};
+
+// Playback of a recorded trace - the scene's car follows one recorded car, the
+// others stand in shafts next to it, and the people waiting show on the landing
+struct Replay {
+    TraceReader trace;
+    int car;
+    std::vector<Elevator> cars;     // Every recorded car, indexed like the trace
+    float time;         // Seconds into the trace
+    float speed;
+    bool paused;
+    int shownSecond;    // Time of day last put in the window title
 };
 
 // Global state
@@ -84,6 +95,7 @@ Camera camera;
 Elevator* globalElevator = nullptr;
 Person* globalPerson = nullptr;
 std::vector<Button3D>* globalButtons = nullptr;
+Replay* globalReplay = nullptr;
 bool firstMouse = true;
 double lastMouseX = 0, lastMouseY = 0;
 bool keys[1024] = {false};
@@ -95,13 +107,223 @@ bool cullFaceEnabled = false;
 void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void mouseCallback(GLFWwindow* window, double xpos, double ypos);
 void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
-float getFloorYPosition(int floor);
 void updateElevator(Elevator& elevator, Person& person, float deltaTime);
+void updateReplay(Replay& replay, Elevator& elevator, Person& person, float deltaTime);
+Vec3 replayShaftOffset(int slot);
+void showReplayTime(GLFWwindow* window, Replay& replay);
 void updateCamera(Camera& camera, Person& person, float deltaTime);
-void addFloorToQueue(Elevator& elevator, int floor);
 
-int main()
+int main(int argc, char** argv)
 {
+    // Trace recording: --record-trace <trace file> [hours] [scenario file] - a day of the office
+    // building by default, followed by timed random seeks into the new trace
+    if (argc > 1 && strcmp(argv[1], "--record-trace") == 0) {
+        if (argc < 3) {
+            std::cout << "Usage: --record-trace <trace file> [hours] [scenario file]" << std::endl;
+            return 1;
+        }
+        float duration = (argc > 3 ? (float)atof(argv[3]) : 24.0f) * 3600.0f;
+        Scenario scenario = defaultScenario();
+        if (argc > 4 && !loadScenario(argv[4], scenario)) return 1;
+        if (!recordTrace(scenario.config, duration, FRAME_TIME, argv[2])) return 1;
+        benchmarkTraceSeeks(argv[2], 1000);
+        return 0;
+    }
+
+    // Headless traffic run: --simulate [minutes] [floors] [decks] [cars per shaft] [--weights <file>] -
+    // more floors than the 3D building get a zoned tower; --weights runs with tuned dispatch weights
+    if (argc > 1 && strcmp(argv[1], "--simulate") == 0) {
+        int positional = argc;
+        const char* weightsPath = nullptr;
+        for (int i = 2; i + 1 < argc; i++) {
+            if (strcmp(argv[i], "--weights") == 0) {
+                weightsPath = argv[i + 1];
+                positional = i;
+                break;
+            }
+        }
+        float duration = (positional > 2 ? (float)atof(argv[2]) : 60.0f) * 60.0f;
+        int floors = positional > 3 ? atoi(argv[3]) : NUM_FLOORS;
+        if (floors < 2 || floors > TRAFFIC_MAX_FLOORS) {
+            std::cout << "Floors must be between 2 and " << TRAFFIC_MAX_FLOORS << std::endl;
+            return 1;
+        }
+        SimConfig config = floors > NUM_FLOORS ? zonedTowerConfig(floors) : defaultSimConfig();
+        config.carDecks = positional > 4 && atoi(argv[4]) > 1 ? MAX_DECKS : 1;
+        config.carsPerShaft = positional > 5 ? std::max(1, atoi(argv[5])) : 1;
+        if (weightsPath) {
+            if (!loadDispatchWeights(weightsPath, config.dispatchByMode)) {
+                std::cout << "No dispatch weights in " << weightsPath << std::endl;
+                return 1;
+            }
+            std::cout << "Dispatch weights:    " << weightsPath << " (tuned)" << std::endl;
+        }
+        SimStats stats = runSimulation(config, duration, FRAME_TIME);
+        printSimStats(stats, duration);
+
+        if (config.carDecks > 1) {
+            SimConfig singleDeck = config;
+            singleDeck.carDecks = 1;
+            SimStats single = runSimulation(singleDeck, duration, FRAME_TIME);
+            std::cout << "Single-deck:         " << single.delivered << " delivered, average wait " << averageWaitTime(single)
+                      << " s (double-deck: " << stats.delivered << ", " << averageWaitTime(stats) << " s)" << std::endl;
+        }
+
+        // Stacked cars are judged against the same shafts holding one car each (the game's
+        // shaft at ELEVATOR_X/ELEVATOR_Z) on the same traffic. Without blocking, n cars in a
+        // shaft would carry n times what one carries, up to the traffic offered.
+        if (config.carsPerShaft > 1) {
+            int perShaft = config.carsPerShaft;
+            SimConfig singleCar = config;
+            singleCar.carsPerShaft = 1;
+            singleCar.numCars = (config.numCars + perShaft - 1) / perShaft;
+            for (Zone& zone : singleCar.zones) zone.numCars = (zone.numCars + perShaft - 1) / perShaft;
+
+            float hour = duration / 3600.0f;
+            float stacked = stats.delivered / hour;
+            float single = runSimulation(singleCar, duration, FRAME_TIME).delivered / hour;
+            float ideal = std::min(single * perShaft, stats.spawned / hour);
+            float gain = single > 0.0f ? (stacked - single) / single * 100.0f : 0.0f;
+            float lost = ideal > 0.0f ? std::max(0.0f, ideal - stacked) / ideal * 100.0f : 0.0f;
+            std::cout << "Throughput:          " << stacked << " passengers/h with " << perShaft << " cars per shaft, "
+                      << single << " with one car per shaft (" << (gain >= 0.0f ? "+" : "") << gain << "% from stacking)" << std::endl;
+            std::cout << "Lost to blocking:    " << lost << "% of " << perShaft << "x the single-car shaft ("
+                      << stats.shaftBlockedTime << " car-s held)" << std::endl;
+        }
+
+        // Idle parking is judged by how much it lowers the average wait against staying put
+        SimConfig stayPut = config;
+        stayPut.parking = ParkingStrategy::None;
+        float parkedWait = averageWaitTime(stats);
+        float stayPutWait = averageWaitTime(runSimulation(stayPut, duration, FRAME_TIME));
+        float reduction = stayPutWait > 0.0f ? (stayPutWait - parkedWait) / stayPutWait * 100.0f : 0.0f;
+        std::cout << "Wait without parking: " << stayPutWait << " s (parking saves " << reduction << "%)" << std::endl;
+
+        // Energy-saving dispatch: kWh saved against the wait it costs
+        SimConfig saving = config;
+        saving.energySaving = true;
+        SimStats savingStats = runSimulation(saving, duration, FRAME_TIME);
+        std::cout << "Energy-saving mode:  " << energyPerPassengerWh(savingStats) << " Wh per passenger (normal " << energyPerPassengerWh(stats)
+                  << "), average wait " << averageWaitTime(savingStats) << " s (normal " << averageWaitTime(stats) << " s)" << std::endl;
+        return 0;
+    }
+
+    // Dispatch weight tuning: --optimize [generations] [population] - the best weights so far
+    // are rewritten to DISPATCH_WEIGHTS_FILE after every generation, for --simulate --weights
+    if (argc > 1 && strcmp(argv[1], "--optimize") == 0) {
+        OptimizerSpec spec = defaultOptimizerSpec();
+        spec.timeStep = FRAME_TIME;
+        if (argc > 2) spec.generations = std::max(1, atoi(argv[2]));
+        if (argc > 3) spec.population = std::max(spec.eliteCount + 1, atoi(argv[3]));
+        DispatchParams best[TRAFFIC_MODE_COUNT];
+        optimizeDispatchWeights(spec, DISPATCH_WEIGHTS_FILE, best);
+        for (int mode = 0; mode < TRAFFIC_MODE_COUNT; mode++) {
+            std::cout << trafficModeName((TrafficMode)mode) << ": stop " << best[mode].stopWeight << ", load " << best[mode].loadWeight << std::endl;
+        }
+        return 0;
+    }
+
+    // Parameter sweep: --sweep [random samples, 0 = full grid] [output.csv] [threads]
+    if (argc > 1 && strcmp(argv[1], "--sweep") == 0) {
+        SweepSpec spec = defaultSweepSpec();
+        spec.timeStep = FRAME_TIME;
+        spec.randomSamples = argc > 2 ? atoi(argv[2]) : 0;
+        const char* output = argc > 3 ? argv[3] : "sweep.csv";
+        int threads = argc > 4 ? atoi(argv[4]) : 0;
+        return runSweep(spec, threads, output) ? 0 : 1;
+    }
+
+    // Scripted passengers: --agents [office workers] [parked agents]
+    if (argc > 1 && strcmp(argv[1], "--agents") == 0) {
+        int workers = argc > 2 ? std::max(0, atoi(argv[2])) : 300;
+        int parked = argc > 3 ? std::max(0, atoi(argv[3])) : 100000;
+        runAgentDay(workers, parked);
+        return 0;
+    }
+
+    // Scenario file run headless: --run-scenario <file>
+    if (argc > 1 && strcmp(argv[1], "--run-scenario") == 0) {
+        if (argc < 3) {
+            std::cout << "Usage: --run-scenario <file>" << std::endl;
+            return 1;
+        }
+        Scenario scenario = defaultScenario();
+        auto start = std::chrono::steady_clock::now();
+        if (!loadScenario(argv[2], scenario)) return 1;
+        double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        double megabytes = scenario.bytesRead / (1024.0 * 1024.0);
+        std::cout << "Loaded " << argv[2] << ": " << scenario.trips.size() << " trips, " << megabytes << " MB in " << loadMs
+                  << " ms (" << (loadMs > 0.0 ? megabytes / (loadMs / 1000.0) : 0.0) << " MB/s)" << std::endl;
+        SimStats stats = runScenario(scenario, FRAME_TIME);
+        printSimStats(stats, scenario.duration);
+        return 0;
+    }
+
+    // Fleet stepping: --bench-fleet [cars] [steps]
+    if (argc > 1 && strcmp(argv[1], "--bench-fleet") == 0) {
+        int cars = argc > 2 ? std::max(1, atoi(argv[2])) : 4096;
+        int steps = argc > 3 ? std::max(1, atoi(argv[3])) : 3600;
+        benchmarkFleet(cars, steps);
+        return 0;
+    }
+
+    // Matrix kernels: --bench-math [matrices] [runs]
+    if (argc > 1 && strcmp(argv[1], "--bench-math") == 0) {
+        int matrices = argc > 2 ? std::max(1, atoi(argv[2])) : 100000;
+        int runs = argc > 3 ? std::max(1, atoi(argv[3])) : 20;
+        benchmarkMath(matrices, runs);
+        return 0;
+    }
+
+    // Batch hall call assignment: --bench-assignment [cars] [calls] times the solver on random
+    // layouts, then compares greedy and batch dispatch on a zoned tower at heavy traffic
+    if (argc > 1 && strcmp(argv[1], "--bench-assignment") == 0) {
+        int cars = argc > 2 ? std::max(1, atoi(argv[2])) : 64;
+        int calls = argc > 3 ? std::max(1, atoi(argv[3])) : 200;
+        benchmarkAssignment(cars, calls, 20);
+
+        float duration = 3600.0f;
+        SimConfig greedy = zonedTowerConfig(60);
+        greedy.traffic.arrivalsPerMinute = 120.0f;
+        SimConfig batch = greedy;
+        batch.assignment = AssignmentMethod::Batch;
+        SimStats greedyStats = runSimulation(greedy, duration, FRAME_TIME);
+        SimStats batchStats = runSimulation(batch, duration, FRAME_TIME);
+        std::cout << "Greedy dispatch:     average wait " << averageWaitTime(greedyStats) << " s, max " << greedyStats.maxWaitTime
+                  << " s, " << greedyStats.delivered << " delivered, "
+                  << greedyStats.bypassedHallCalls << " calls bypassed" << std::endl;
+        std::cout << "Batch dispatch:      average wait " << averageWaitTime(batchStats) << " s, max " << batchStats.maxWaitTime
+                  << " s, " << batchStats.delivered << " delivered, "
+                  << batchStats.bypassedHallCalls << " calls bypassed" << std::endl;
+        return 0;
+    }
+
+    // 3D building from a scenario file: --scenario <file> (defaults to the office building below)
+    Scenario scenario = defaultScenario();
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--scenario") == 0 && !loadScenario(argv[i + 1], scenario)) return 1;
+    }
+
+    // Trace playback: --replay <trace file> [car] - the person rides "car", left/right scrub
+    // 10 s (1 h with shift), up/down double or halve the speed, space pauses
+    Replay replay;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--replay") != 0) continue;
+        if (!openTrace(replay.trace, argv[i + 1])) return 1;
+        if (replay.trace.header.numFloors > NUM_FLOORS) {
+            std::cout << "The trace has " << replay.trace.header.numFloors << " floors, the 3D building " << NUM_FLOORS << std::endl;
+            return 1;
+        }
+        int car = i + 2 < argc ? atoi(argv[i + 2]) : 0;
+        replay.car = std::max(0, std::min(car, replay.trace.header.numCars - 1));
+        replay.cars.assign(replay.trace.header.numCars, Elevator{0.0f, 0, 0, false, false, 0.0f, 0.0f, false, {}});
+        replay.time = 0.0f;
+        replay.speed = 1.0f;
+        replay.paused = false;
+        replay.shownSecond = -1;
+        globalReplay = &replay;
+    }
+
     if (!glfwInit()) return endProgram("GLFW nije uspelo da se inicijalizuje.");
     
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -132,14 +354,33 @@ int main()
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     // Create shaders
-    unsigned int shader3D = createShader("Shaders/3d.vert", "Shaders/3d.frag");
-    unsigned int colorShader3D = createShader("Shaders/3d.vert", "Shaders/3d_color.frag");
-    unsigned int shader2D = createShader("Shaders/basic.vert", "Shaders/basic.frag");
-    unsigned int colorShader2D = createShader("Shaders/color2d.vert", "Shaders/color2d.frag");
+    ShaderProgram shader3D = createShaderProgram("Shaders/3d.vert", "Shaders/3d.frag");
+    ShaderProgram colorShader3D = createShaderProgram("Shaders/3d.vert", "Shaders/3d_color.frag");
+    // Building surfaces, buttons and plants sample layers of texture arrays
+    ShaderProgram layeredShader3D = createShaderProgram("Shaders/3d.vert", "Shaders/3d_array.frag");
+    ShaderProgram instancedShader3D = createShaderProgram("Shaders/3d_instanced.vert", "Shaders/3d_array.frag");
+    ShaderProgram shader2D = createShaderProgram("Shaders/basic.vert", "Shaders/basic.frag");
+    ShaderProgram colorShader2D = createShaderProgram("Shaders/color2d.vert", "Shaders/color2d.frag");
+
+    // Camera and light passes for both 3D programs, filled once per frame
+    FrameUniforms frameUniforms;
+    createFrameUniforms(frameUniforms);
+    bindFrameBlocks(shader3D);
+    bindFrameBlocks(colorShader3D);
+    bindFrameBlocks(layeredShader3D);
+    bindFrameBlocks(instancedShader3D);
+    ButtonLightBuffer buttonLights;
+    createButtonLights(buttonLights);
+    // Uniforms keep their value in the program - opaque 3D draws never change alpha
+    for (const ShaderProgram* program : {&shader3D, &layeredShader3D, &instancedShader3D}) {
+        glUseProgram(program->id);
+        setShaderFloat(*program, U_ALPHA, 1.0f);
+    }
 
     // Create 3D geometry VAOs
-    unsigned int floorVAO = create3DQuadVAO();
     unsigned int wallVAO = createWallVAO();
+    // Floors, walls, ceilings and the cabin shell, pre-transformed into one buffer
+    BuildingGeometry building = createBuildingGeometry();
     unsigned int cubeVAO = createCubeVAO();
 
     // 2D quad VAO for UI/crosshair
@@ -182,29 +423,29 @@ int main()
     unsigned int depthOnTex = loadImageToTexture("Resources/depth_on.png");
     unsigned int depthOffTex = loadImageToTexture("Resources/depth_off.png");
     
-    setTextureFiltering(elevatorWallTex);
-    setTextureFiltering(elevatorDoorClosedTex);
-    setTextureFiltering(elevatorDoorOpenTex);
     setTextureFiltering(crosshairTex);
     setTextureFiltering(studentInfoTex);
-    setTextureFiltering(podTex);
-    setTextureFiltering(plafonTex);
     if (cullOnTex) setTextureFiltering(cullOnTex);
     if (cullOffTex) setTextureFiltering(cullOffTex);
     if (depthOnTex) setTextureFiltering(depthOnTex);
     if (depthOffTex) setTextureFiltering(depthOffTex);
 
     // Load floor-specific textures (all 4 walls same texture per floor)
-    unsigned int floorTextures[8];
-    floorTextures[0] = loadImageToTexture("Resources/podrum.jpg");
-    floorTextures[1] = loadImageToTexture("Resources/prizemlje.jpg");
-    floorTextures[2] = loadImageToTexture("Resources/prviSprat.jpg");
-    floorTextures[3] = loadImageToTexture("Resources/drugiSprat.jpg");
-    floorTextures[4] = loadImageToTexture("Resources/treciSprat.jpg");
-    floorTextures[5] = loadImageToTexture("Resources/cetvrtiSprat.jpg");
-    floorTextures[6] = loadImageToTexture("Resources/petiSprat.jpg");
-    floorTextures[7] = loadImageToTexture("Resources/sestiSprat.jpg");
-    for (int i = 0; i < 8; i++) setTextureFiltering(floorTextures[i]);
+    std::vector<unsigned int> surfaceTextures;
+    for (int i = 0; i < NUM_FLOORS; i++) {
+        surfaceTextures.push_back(loadImageToTexture(scenario.floorTextures[i].c_str()));
+    }
+
+    // Every building surface in one array, so the baked ranges share a binding:
+    // layer i is the wall texture of floor i, the shared surfaces follow
+    const int LAYER_POD = NUM_FLOORS;
+    const int LAYER_PLAFON = NUM_FLOORS + 1;
+    const int LAYER_METAL = NUM_FLOORS + 2;
+    const int LAYER_DOOR_CLOSED = NUM_FLOORS + 3;
+    const int LAYER_DOOR_OPEN = NUM_FLOORS + 4;
+    surfaceTextures.insert(surfaceTextures.end(), {podTex, plafonTex, elevatorWallTex, elevatorDoorClosedTex, elevatorDoorOpenTex});
+    unsigned int buildingTextures = createTextureArray(surfaceTextures, 1024);
+    glDeleteTextures((int)surfaceTextures.size(), surfaceTextures.data());
 
     // Load 3D plant models
     OBJModel plant1 = loadOBJModel("Resources/indoor-plant-1/source/pflant_1/pflant_1.obj", 
@@ -219,7 +460,7 @@ int main()
                                         "Resources/ceiling-light/textures/FluorescentLight_Base_Color.png");
 
     // Create button panel - 2 columns of 6 buttons each
-    std::vector<Button3D> buttons(12);
+    std::vector<Button3D> buttons;
     float btnSize = 0.15f;      
     float btnSpacingY = 0.20f;  
     
@@ -229,27 +470,50 @@ int main()
     
     float btnStartY = 1.8f;  // Start from center height
     
-    // Left column (6 buttons: floors 6, 5, 4, 3, 2, 1)
-    buttons[7] = {Vec3(0.0f, btnStartY, leftColZ), btnSize, btnSize, loadImageToTexture("Resources/taster6.png"), 7, false};
-    buttons[6] = {Vec3(0.0f, btnStartY - btnSpacingY, leftColZ), btnSize, btnSize, loadImageToTexture("Resources/taster5.png"), 6, false};
-    buttons[5] = {Vec3(0.0f, btnStartY - 2*btnSpacingY, leftColZ), btnSize, btnSize, loadImageToTexture("Resources/taster4.png"), 5, false};
-    buttons[4] = {Vec3(0.0f, btnStartY - 3*btnSpacingY, leftColZ), btnSize, btnSize, loadImageToTexture("Resources/taster3.png"), 4, false};
-    buttons[3] = {Vec3(0.0f, btnStartY - 4*btnSpacingY, leftColZ), btnSize, btnSize, loadImageToTexture("Resources/taster2.png"), 3, false};
-    buttons[2] = {Vec3(0.0f, btnStartY - 5*btnSpacingY, leftColZ), btnSize, btnSize, loadImageToTexture("Resources/taster1.png"), 2, false};
-    
-    // Right column (6 buttons: PR, SU, Open, Close, Stop, Ventilation)
-    buttons[1] = {Vec3(0.0f, btnStartY, rightColZ), btnSize, btnSize, loadImageToTexture("Resources/tasterPrizemlje.png"), 1, false};
-    buttons[0] = {Vec3(0.0f, btnStartY - btnSpacingY, rightColZ), btnSize, btnSize, loadImageToTexture("Resources/tasterSuteren.png"), 0, false};
-    buttons[8] = {Vec3(0.0f, btnStartY - 2*btnSpacingY, rightColZ), btnSize, btnSize, loadImageToTexture("Resources/tasterOtvaranje.png"), -1, false};
-    buttons[9] = {Vec3(0.0f, btnStartY - 3*btnSpacingY, rightColZ), btnSize, btnSize, loadImageToTexture("Resources/tasterZatvaranje.png"), -2, false};
-    buttons[10] = {Vec3(0.0f, btnStartY - 4*btnSpacingY, rightColZ), btnSize, btnSize, loadImageToTexture("Resources/tasterStop.png"), -3, false};
-    buttons[11] = {Vec3(0.0f, btnStartY - 5*btnSpacingY, rightColZ), btnSize, btnSize, loadImageToTexture("Resources/tasterVentilacija.png"), -4, false};
+    std::vector<unsigned int> buttonTextures;
+    for (const ScenarioButton& b : scenario.buttons) {
+        Vec3 position(0.0f, btnStartY - b.row * btnSpacingY, b.column == 0 ? leftColZ : rightColZ);
+        buttons.push_back({position, btnSize, btnSize, (int)buttonTextures.size(), b.action, false});
+        buttonTextures.push_back(loadImageToTexture(b.texture.c_str()));
+    }
+
+    // All button faces in one texture array, so the whole panel is a single instanced draw
+    InstanceBatch buttonBatch;
+    createInstanceBatch(buttonBatch, wallVAO, 6, true);
+    unsigned int buttonFaces = createTextureArray(buttonTextures, 256);
+    glDeleteTextures((int)buttonTextures.size(), buttonTextures.data());
 
-    for (auto& btn : buttons) setTextureFiltering(btn.texture);
+    // One batch per plant type - a copy for every plant of that type in view
+    const OBJModel* plants[3] = {&plant1, &plant2, &plant3};
+    InstanceBatch plantBatches[3] = {};
+    for (int i = 0; i < 3; i++) {
+        if (plants[i]->VAO != 0) createInstanceBatch(plantBatches[i], plants[i]->VAO, plants[i]->vertexCount, false);
+    }
+    // A box per person waiting on a replayed landing
+    InstanceBatch waitingBatch;
+    createInstanceBatch(waitingBatch, cubeVAO, 36, true);
+    // Layer i is the texture of plant type i
+    unsigned int plantTextures = createTextureArray({plant1.texture, plant2.texture, plant3.texture}, 1024);
+    for (OBJModel* plant : {&plant1, &plant2, &plant3}) {
+        if (plant->texture != 0) glDeleteTextures(1, &plant->texture);
+        plant->texture = 0;
+    }
 
     // Initialize elevator and person
-    Elevator elevator = {getFloorYPosition(2), 2, 2, false, false, 0.0f, 3.0f, false, {}};
-    Person person = {Vec3(0.0f, getFloorYPosition(1) + 1.7f, 0.0f), false, 1, 5.0f};
+    int carFloor = scenario.carStartFloor;
+    Elevator elevator = {getFloorYPosition(carFloor), carFloor, carFloor, false, false, 0.0f, scenario.config.carSpeed, false, {}};
+    elevator.decks = scenario.config.carDecks;
+    elevator.doorOpenTime = scenario.config.doorOpenTime;
+    elevator.doorExtendedTime = scenario.config.doorExtendedTime;
+    elevator.capacityPersons = scenario.config.capacityPersons;
+    elevator.capacityKg = scenario.config.capacityKg;
+    int personFloor = scenario.personStartFloor;
+    Person person = {Vec3(0.0f, getFloorYPosition(personFloor) + 1.7f, 0.0f), false, personFloor, 5.0f, PASSENGER_WEIGHT_KG, 0};
+
+    // --double-deck: the car gets a second cabin and stops at floor pairs (0-1, 2-3, ...)
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--double-deck") == 0) elevator.decks = MAX_DECKS;
+    }
 
     // Initialize camera
     camera = {person.position, PI, 0.0f, 0.002f, 5.0f};
@@ -278,6 +542,17 @@ int main()
 
     glClearColor(0.05f, 0.05f, 0.08f, 1.0f);  // Darker background
 
+    RenderQueue renderQueue;
+    // Per-draw model and ambient of the building ranges, read by the indirect draws
+    InstanceBatch buildingDraws;
+    createInstanceBatch(buildingDraws, building.VAO, 0, true);
+    if (!enableIndirectDraws(renderQueue, instancedShader3D, buildingDraws))
+        std::cout << "Multi-draw indirect not supported, building drawn one call per range" << std::endl;
+
+    // Loading bound VAOs and textures behind the state cache's back
+    resetGLState();
+    long long framesDrawn = 0;
+
     while (!glfwWindowShouldClose(window))
     {
         double currentTime = glfwGetTime();
@@ -289,12 +564,29 @@ int main()
         {
             accumulator -= FRAME_TIME;
 
-            updateElevator(elevator, person, FRAME_TIME);
+            if (globalReplay) {
+                updateReplay(replay, elevator, person, FRAME_TIME);
+                showReplayTime(window, replay);
+            } else {
+                updateElevator(elevator, person, FRAME_TIME);
+            }
             updateCamera(camera, person, FRAME_TIME);
 
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
             Mat4 view = camera.getViewMatrix();
+            setFrameCamera(frameUniforms, view, projection, camera.position);
+            Vec3 warmWhite(1.0f, 0.95f, 0.9f);
+
+            // Scene draws are queued and submitted sorted by state after the branch below
+            beginRenderQueue(renderQueue, camera.position);
+            auto drawRange = [&](RenderPass pass, int layer, const DrawRange& range, float ambient, const Mat4& model) {
+                submitRange(renderQueue, pass, layeredShader3D, building.VAO, buildingTextures, layer, range, ambient, model);
+            };
+            auto drawModel = [&](RenderPass pass, const OBJModel& object, float ambient, const Mat4& model) {
+                if (object.VAO == 0) return;
+                submitDraw(renderQueue, pass, shader3D, object.VAO, object.texture, object.vertexCount, false, ambient, model);
+            };
 
             // ========== RENDER CURRENT FLOOR ==========
             if (!person.inElevator) {
@@ -304,81 +596,37 @@ int main()
                 // Floor lamp position - centered on ceiling, slightly below the actual lamp model
                 Vec3 floorLightPos(0.0f, floorY + FLOOR_HEIGHT - 1.5f, 0.0f);
                 
-                glUseProgram(shader3D);
-                setShaderMat4(shader3D, "uView", view);
-                setShaderMat4(shader3D, "uProjection", projection);
-                setShaderVec3(shader3D, "uLightPos", floorLightPos);
-                setShaderVec3(shader3D, "uViewPos", camera.position);
-                setShaderVec3(shader3D, "uLightColor", Vec3(1.0f, 0.95f, 0.9f));    // Warm white light
-                setShaderFloat(shader3D, "uAmbientStrength", 0.25f);                // Moderate ambient for visible corners
-                setShaderFloat(shader3D, "uConstant", lightConstant);
-                setShaderFloat(shader3D, "uLinear", lightLinear);
-                setShaderFloat(shader3D, "uQuadratic", lightQuadratic);
-                setShaderFloat(shader3D, "uAlpha", 1.0f);
-                // No button lights when outside elevator
-                glUniform1i(glGetUniformLocation(shader3D, "uNumButtonLights"), 0);
-                glActiveTexture(GL_TEXTURE0);
-                
-                // Floor (pod.png)
-                Mat4 floorModel = Mat4::translate(Vec3(0.0f, floorY, 0.0f)) * Mat4::scale(Vec3(FLOOR_WIDTH, 1.0f, FLOOR_DEPTH));
-                setShaderMat4(shader3D, "uModel", floorModel);
-                glBindTexture(GL_TEXTURE_2D, podTex);
-                glBindVertexArray(floorVAO);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+                int floorLight = addFrameLight(frameUniforms, floorLightPos, warmWhite, lightConstant, lightLinear, lightQuadratic);
+                uploadFrameUniforms(frameUniforms);
+                setQueueLight(renderQueue, floorLight);
                 
-                // Ceiling (plafon.jpg)
-                Mat4 ceilingModel = Mat4::translate(Vec3(0.0f, floorY + FLOOR_HEIGHT, 0.0f)) * 
-                                   Mat4::rotateX(PI) * Mat4::scale(Vec3(FLOOR_WIDTH, 1.0f, FLOOR_DEPTH));
-                setShaderMat4(shader3D, "uModel", ceilingModel);
-                glBindTexture(GL_TEXTURE_2D, plafonTex);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                
-                // all 4 walls - same texture for current floor
-                glBindTexture(GL_TEXTURE_2D, floorTextures[floor]);
-                glBindVertexArray(wallVAO);
-                
-                // Back wall
-                Mat4 backWall = Mat4::translate(Vec3(0.0f, floorY + FLOOR_HEIGHT/2, -FLOOR_DEPTH/2)) * 
-                               Mat4::scale(Vec3(FLOOR_WIDTH, FLOOR_HEIGHT, 1.0f));
-                setShaderMat4(shader3D, "uModel", backWall);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                
-                // Front wall
-                Mat4 frontWall = Mat4::translate(Vec3(0.0f, floorY + FLOOR_HEIGHT/2, FLOOR_DEPTH/2)) * 
-                                Mat4::rotateY(PI) * Mat4::scale(Vec3(FLOOR_WIDTH, FLOOR_HEIGHT, 1.0f));
-                setShaderMat4(shader3D, "uModel", frontWall);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                
-                // Left wall
-                Mat4 leftWall = Mat4::translate(Vec3(-FLOOR_WIDTH/2, floorY + FLOOR_HEIGHT/2, 0.0f)) * 
-                               Mat4::rotateY(PI/2) * Mat4::scale(Vec3(FLOOR_DEPTH, FLOOR_HEIGHT, 1.0f));
-                setShaderMat4(shader3D, "uModel", leftWall);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+                float floorAmbient = 0.25f;                // Moderate ambient for visible corners
+                // No button lights when outside elevator
+                ButtonLightBlock noButtonLights = {};
+                updateButtonLights(buttonLights, noButtonLights);
                 
-                // Right wall
-                Mat4 rightWall = Mat4::translate(Vec3(FLOOR_WIDTH/2, floorY + FLOOR_HEIGHT/2, 0.0f)) * 
-                                Mat4::rotateY(-PI/2) * Mat4::scale(Vec3(FLOOR_DEPTH, FLOOR_HEIGHT, 1.0f));
-                setShaderMat4(shader3D, "uModel", rightWall);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+                // Floor (pod.png), ceiling (plafon.jpg) and all 4 walls - same texture for current floor
+                Mat4 identity;
+                drawRange(RENDER_TRANSPARENT, LAYER_POD, building.floors[floor], floorAmbient, identity);
+                drawRange(RENDER_OPAQUE, LAYER_PLAFON, building.ceilings[floor], floorAmbient, identity);
+                drawRange(RENDER_OPAQUE, floor, building.walls[floor], floorAmbient, identity);
                 
                 // ========== RENDER PLANTS IN CORNERS ==========
                 float plantScale = 0.4875f;
                 float cornerOffset = 1.5f;
                 
-                // Front-left corner (plant 1)
-                Mat4 plant1Model = Mat4::translate(Vec3(-FLOOR_WIDTH/2 + cornerOffset, floorY, FLOOR_DEPTH/2 - cornerOffset)) *
-                                   Mat4::scale(Vec3(plantScale, plantScale, plantScale));
-                renderOBJModel(plant1, shader3D, plant1Model, view, projection, floorLightPos, camera.position);
-                
-                // Front-right corner (plant 2)
-                Mat4 plant2Model = Mat4::translate(Vec3(FLOOR_WIDTH/2 - cornerOffset, floorY, FLOOR_DEPTH/2 - cornerOffset)) *
-                                   Mat4::scale(Vec3(plantScale, plantScale, plantScale));
-                renderOBJModel(plant2, shader3D, plant2Model, view, projection, floorLightPos, camera.position);
-                
-                // Back-left corner (plant 3)
-                Mat4 plant3Model = Mat4::translate(Vec3(-FLOOR_WIDTH/2 + cornerOffset, floorY, -FLOOR_DEPTH/2 + cornerOffset)) *
-                                   Mat4::scale(Vec3(plantScale, plantScale, plantScale));
-                renderOBJModel(plant3, shader3D, plant3Model, view, projection, floorLightPos, camera.position);
+                // Front-left (plant 1), front-right (plant 2) and back-left corner (plant 3)
+                Vec3 plantCorners[3] = {
+                    Vec3(-FLOOR_WIDTH/2 + cornerOffset, floorY, FLOOR_DEPTH/2 - cornerOffset),
+                    Vec3(FLOOR_WIDTH/2 - cornerOffset, floorY, FLOOR_DEPTH/2 - cornerOffset),
+                    Vec3(-FLOOR_WIDTH/2 + cornerOffset, floorY, -FLOOR_DEPTH/2 + cornerOffset)
+                };
+                for (int i = 0; i < 3; i++) {
+                    if (plants[i]->VAO == 0) continue;
+                    Mat4 plantModel = Mat4::placement(plantCorners[i], 0.0f, Vec3(plantScale, plantScale, plantScale));
+                    addInstance(plantBatches[i], plantModel, floorAmbient, i);
+                    submitInstances(renderQueue, RENDER_TRANSPARENT, instancedShader3D, plantBatches[i], plantTextures);
+                }
                 
                 // ========== RENDER CEILING LIGHT (centered on ceiling) ==========
                 float lightScale = 1.2f;
@@ -386,269 +634,115 @@ int main()
                                  Mat4::rotateY(PI/2) *
                                  Mat4::scale(Vec3(lightScale, lightScale, lightScale));
                 
-                // Disable blending for opaque rendering of the lamp
-                glDisable(GL_BLEND);
-                
-                glUseProgram(shader3D);
-                setShaderMat4(shader3D, "uModel", lightModel);
-                setShaderMat4(shader3D, "uView", view);
-                setShaderMat4(shader3D, "uProjection", projection);
-                setShaderVec3(shader3D, "uLightPos", floorLightPos);
-                setShaderVec3(shader3D, "uViewPos", camera.position);
-                setShaderVec3(shader3D, "uLightColor", Vec3(1.0f, 0.95f, 0.9f));
-                setShaderFloat(shader3D, "uAmbientStrength", 0.9f);      // Lamp itself is bright
-                setShaderFloat(shader3D, "uConstant", lightConstant);
-                setShaderFloat(shader3D, "uLinear", lightLinear);
-                setShaderFloat(shader3D, "uQuadratic", lightQuadratic);
-                setShaderFloat(shader3D, "uAlpha", 1.0f);
-                
-                if (ceilingLight.texture > 0) {
-                    glActiveTexture(GL_TEXTURE0);
-                    glBindTexture(GL_TEXTURE_2D, ceilingLight.texture);
-                }
-                
-                glBindVertexArray(ceilingLight.VAO);
-                glDrawArrays(GL_TRIANGLES, 0, ceilingLight.vertexCount);
-                glBindVertexArray(0);
-
-                // Re-enable blending for other objects
-                glEnable(GL_BLEND);
+                // Opaque, and the lamp itself is bright
+                drawModel(RENDER_OPAQUE, ceilingLight, 0.9f, lightModel);
                 
                 // ========== RENDER ELEVATOR EXTERIOR (cube in corner) ==========
                 // When player is otuside the elevator, render exterior walls
                 // Normals must point outward from the elevator for correct culling
-                float cabinY = elevator.y + ELEVATOR_SIZE/2;
-                
                 // Use existing floorLightPos for exterior lighting
-                
-                glUseProgram(shader3D);
-                setShaderMat4(shader3D, "uView", view);
-                setShaderMat4(shader3D, "uProjection", projection);
-                setShaderVec3(shader3D, "uLightPos", floorLightPos);
-                setShaderVec3(shader3D, "uViewPos", camera.position);
-                setShaderVec3(shader3D, "uLightColor", Vec3(1.0f, 0.95f, 0.9f));
-                setShaderFloat(shader3D, "uAmbientStrength", 0.25f);
-                setShaderFloat(shader3D, "uConstant", lightConstant);
-                setShaderFloat(shader3D, "uLinear", lightLinear);
-                setShaderFloat(shader3D, "uQuadratic", lightQuadratic);
-                setShaderFloat(shader3D, "uAlpha", 1.0f);
-                glUniform1i(glGetUniformLocation(shader3D, "uNumButtonLights"), 0);
-                glActiveTexture(GL_TEXTURE0);
-                
-                // Top wall of elevator (metal ceiling) - use floorVAO for horizontal surface
-                glBindVertexArray(floorVAO);
-                glBindTexture(GL_TEXTURE_2D, elevatorWallTex);
-                Mat4 elevTop = Mat4::translate(Vec3(ELEVATOR_X, elevator.y + ELEVATOR_SIZE, ELEVATOR_Z)) * 
-                              Mat4::rotateX(PI) * Mat4::scale(Vec3(ELEVATOR_SIZE, 1.0f, ELEVATOR_SIZE));
-                setShaderMat4(shader3D, "uModel", elevTop);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                
-                // Vertical walls use wallVAO - exterior facing (normals pointing outward)
-                glBindVertexArray(wallVAO);
-                glBindTexture(GL_TEXTURE_2D, elevatorWallTex);
-                
-                // Back wall of elevator (metal) - exterior faces -Z direction
-                Mat4 elevBack = Mat4::translate(Vec3(ELEVATOR_X, cabinY, ELEVATOR_Z - ELEVATOR_SIZE/2)) * 
-                               Mat4::rotateY(PI) * Mat4::scale(Vec3(ELEVATOR_SIZE, ELEVATOR_SIZE, 1.0f));
-                setShaderMat4(shader3D, "uModel", elevBack);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                
-                // Left wall of elevator (metal) - exterior faces -X direction
-                Mat4 elevLeft = Mat4::translate(Vec3(ELEVATOR_X - ELEVATOR_SIZE/2, cabinY, ELEVATOR_Z)) * 
-                               Mat4::rotateY(-PI/2) * Mat4::scale(Vec3(ELEVATOR_SIZE, ELEVATOR_SIZE, 1.0f));
-                setShaderMat4(shader3D, "uModel", elevLeft);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                
-                // Right wall of elevator (metal) - exterior faces +X direction
-                Mat4 elevRight = Mat4::translate(Vec3(ELEVATOR_X + ELEVATOR_SIZE/2, cabinY, ELEVATOR_Z)) * 
-                                Mat4::rotateY(PI/2) * Mat4::scale(Vec3(ELEVATOR_SIZE, ELEVATOR_SIZE, 1.0f));
-                setShaderMat4(shader3D, "uModel", elevRight);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                
-                // Front door - render based on door state - exterior faces +Z direction
-                if (elevator.doorsOpen) {
-                    // Doors open - render otvorenLift.png
-                    Mat4 elevFront = Mat4::translate(Vec3(ELEVATOR_X, cabinY, ELEVATOR_Z + ELEVATOR_SIZE/2)) * 
-                                    Mat4::scale(Vec3(ELEVATOR_SIZE, ELEVATOR_SIZE, 1.0f));
-                    setShaderMat4(shader3D, "uModel", elevFront);
-                    glBindTexture(GL_TEXTURE_2D, elevatorDoorOpenTex);
-                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                } else {
-                    // Doors closed - render zatvorenLift.png
-                    Mat4 elevFront = Mat4::translate(Vec3(ELEVATOR_X, cabinY, ELEVATOR_Z + ELEVATOR_SIZE/2)) * 
-                                    Mat4::scale(Vec3(ELEVATOR_SIZE, ELEVATOR_SIZE, 1.0f));
-                    setShaderMat4(shader3D, "uModel", elevFront);
-                    glBindTexture(GL_TEXTURE_2D, elevatorDoorClosedTex);
-                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+                auto drawCabinExterior = [&](const Elevator& car, const Vec3& shaftOffset) {
+                    for (int deck = 0; deck < car.decks; deck++) {
+                        Mat4 cabinModel = Mat4::translate(shaftOffset + Vec3(0.0f, car.y + deck * FLOOR_HEIGHT, 0.0f));
+                        // Metal top and walls, then the door based on its state:
+                        // otvorenLift.png when the doors are open, zatvorenLift.png when closed
+                        drawRange(RENDER_OPAQUE, LAYER_METAL, building.cabinExterior, floorAmbient, cabinModel);
+                        drawRange(RENDER_TRANSPARENT, car.doorsOpen ? LAYER_DOOR_OPEN : LAYER_DOOR_CLOSED,
+                                  building.cabinExteriorDoor, floorAmbient, cabinModel);
+                    }
+                };
+                drawCabinExterior(elevator, Vec3(0.0f, 0.0f, 0.0f));
+
+                if (globalReplay) {
+                    // The other recorded cars, then the people waiting here in front of the shaft
+                    for (int k = 0, slot = 1; k < (int)replay.cars.size(); k++) {
+                        if (k != replay.car) drawCabinExterior(replay.cars[k], replayShaftOffset(slot++));
+                    }
+                    const std::vector<uint16_t>& waitingPerFloor = replay.trace.frame.waiting;
+                    int waiting = floor < (int)waitingPerFloor.size() ? std::min((int)waitingPerFloor[floor], MAX_WAITING_SHOWN) : 0;
+                    for (int i = 0; i < waiting; i++) {
+                        Vec3 spot(ELEVATOR_X + 1.0f - (i % 8) * 0.7f, floorY + 0.85f,
+                                  ELEVATOR_Z + ELEVATOR_SIZE / 2 + 0.6f + (i / 8) * 0.6f);
+                        addInstance(waitingBatch, Mat4::placement(spot, 0.0f, Vec3(0.4f, 1.7f, 0.4f)), floorAmbient, LAYER_METAL);
+                    }
+                    if (waiting > 0) submitInstances(renderQueue, RENDER_OPAQUE, instancedShader3D, waitingBatch, buildingTextures);
                 }
             }
             else {
                 // ========== RENDER ELEVATOR INTERIOR ==========
-                float cabinY = elevator.y + ELEVATOR_SIZE/2;
-                
-                // Elevator interior lamp position - centered on elevator ceiling
-                Vec3 elevatorLightPos(ELEVATOR_X, elevator.y + ELEVATOR_SIZE - 0.5f, ELEVATOR_Z);
+                // The panel is in the person's cabin - the other cabin of a double-deck car is drawn the same way
+                float personCabinBase = elevator.y + person.deck * FLOOR_HEIGHT;
                 
-                // Collect button light positions for lighting the elevator interior
+                // Button lights relative to the panel origin, which follows the cabin through the Frame block
                 // Light position is slightly in front of the button surface for visible glow
-                std::vector<Vec3> buttonLightPositions;
-                std::vector<int> buttonLightActive;
-                for (auto& btn : buttons) {
-                    Vec3 btnWorldPos(ELEVATOR_X - ELEVATOR_SIZE/2 + 0.04f,  // Close to button surface
-                                    elevator.y + btn.position.y, 
-                                    ELEVATOR_Z + btn.position.z);
-                    buttonLightPositions.push_back(btnWorldPos);
-                    buttonLightActive.push_back(btn.isPressed ? 1 : 0);
+                setFramePanelOrigin(frameUniforms, Vec3(ELEVATOR_X, personCabinBase, ELEVATOR_Z));
+                ButtonLightBlock buttonLightBlock = {};
+                buttonLightBlock.count = std::min((int)buttons.size(), MAX_BUTTON_LIGHTS);
+                for (int i = 0; i < buttonLightBlock.count; i++) {
+                    buttonLightBlock.lights[i][0] = -ELEVATOR_SIZE/2 + 0.04f;  // Close to button surface
+                    buttonLightBlock.lights[i][1] = buttons[i].position.y;
+                    buttonLightBlock.lights[i][2] = buttons[i].position.z;
+                    buttonLightBlock.lights[i][3] = buttons[i].isPressed ? 1.0f : 0.0f;
                 }
+                updateButtonLights(buttonLights, buttonLightBlock);
                 
-                // Lambda to set button light uniforms
-                auto setButtonLightUniforms = [&](unsigned int shader) {
-                    glUniform1i(glGetUniformLocation(shader, "uNumButtonLights"), (int)buttonLightPositions.size());
-                    for (size_t j = 0; j < buttonLightPositions.size(); j++) {
-                        std::string posName = "uButtonLightPos[" + std::to_string(j) + "]";
-                        std::string activeName = "uButtonLightActive[" + std::to_string(j) + "]";
-                        glUniform3f(glGetUniformLocation(shader, posName.c_str()), 
-                                   buttonLightPositions[j].x, buttonLightPositions[j].y, buttonLightPositions[j].z);
-                        glUniform1i(glGetUniformLocation(shader, activeName.c_str()), buttonLightActive[j]);
-                    }
-                };
-                
-                glUseProgram(shader3D);
-                setShaderMat4(shader3D, "uView", view);
-                setShaderMat4(shader3D, "uProjection", projection);
-                setShaderVec3(shader3D, "uLightPos", elevatorLightPos);
-                setShaderVec3(shader3D, "uViewPos", camera.position);
-                setShaderVec3(shader3D, "uLightColor", Vec3(1.0f, 0.95f, 0.9f));    // Warm white light
-                setShaderFloat(shader3D, "uAmbientStrength", 0.2f);                 // Low ambient for realistic lighting
-                setShaderFloat(shader3D, "uConstant", lightConstant);
-                setShaderFloat(shader3D, "uLinear", 0.14f);                         // Slightly stronger falloff for smaller space
-                setShaderFloat(shader3D, "uQuadratic", 0.07f);
-                setShaderFloat(shader3D, "uAlpha", 1.0f);
-                setButtonLightUniforms(shader3D);
-                glActiveTexture(GL_TEXTURE0);
-                
-                glBindTexture(GL_TEXTURE_2D, elevatorWallTex);  // Metal texture
-                glBindVertexArray(wallVAO);
-                
-                // All 4 walls (metal)
-                Mat4 elevBackWall = Mat4::translate(Vec3(ELEVATOR_X, cabinY, ELEVATOR_Z - ELEVATOR_SIZE/2)) * 
-                                   Mat4::scale(Vec3(ELEVATOR_SIZE, ELEVATOR_SIZE, 1.0f));
-                setShaderMat4(shader3D, "uModel", elevBackWall);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                
-                Mat4 elevLeftWall = Mat4::translate(Vec3(ELEVATOR_X - ELEVATOR_SIZE/2, cabinY, ELEVATOR_Z)) * 
-                                   Mat4::rotateY(PI/2) * Mat4::scale(Vec3(ELEVATOR_SIZE, ELEVATOR_SIZE, 1.0f));
-                setShaderMat4(shader3D, "uModel", elevLeftWall);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                
-                Mat4 elevRightWall = Mat4::translate(Vec3(ELEVATOR_X + ELEVATOR_SIZE/2, cabinY, ELEVATOR_Z)) * 
-                                    Mat4::rotateY(-PI/2) * Mat4::scale(Vec3(ELEVATOR_SIZE, ELEVATOR_SIZE, 1.0f));
-                setShaderMat4(shader3D, "uModel", elevRightWall);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                
-                // Front wall (door) - based on door state
-                if (elevator.doorsOpen) {
-                    // Doors open - show otvorenLift.png (person can see open door texture)
-                    Mat4 elevDoor = Mat4::translate(Vec3(ELEVATOR_X, cabinY, ELEVATOR_Z + ELEVATOR_SIZE/2)) * 
-                                   Mat4::rotateY(PI) * Mat4::scale(Vec3(ELEVATOR_SIZE, ELEVATOR_SIZE, 1.0f));
-                    setShaderMat4(shader3D, "uModel", elevDoor);
-                    glBindTexture(GL_TEXTURE_2D, elevatorDoorOpenTex);
-                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-                } else {
-                    // Doors closed - show zatvorenLift.png
-                    Mat4 elevDoor = Mat4::translate(Vec3(ELEVATOR_X, cabinY, ELEVATOR_Z + ELEVATOR_SIZE/2)) * 
-                                   Mat4::rotateY(PI) * Mat4::scale(Vec3(ELEVATOR_SIZE, ELEVATOR_SIZE, 1.0f));
-                    setShaderMat4(shader3D, "uModel", elevDoor);
-                    glBindTexture(GL_TEXTURE_2D, elevatorDoorClosedTex);
-                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+                // One light pass per cabin, each lit by its own ceiling lamp
+                int cabinLights[MAX_DECKS] = {0, 0};
+                for (int deck = 0; deck < elevator.decks; deck++) {
+                    Vec3 cabinLightPos(ELEVATOR_X, elevator.y + deck * FLOOR_HEIGHT + ELEVATOR_SIZE - 0.5f, ELEVATOR_Z);
+                    // Slightly stronger falloff for smaller space
+                    cabinLights[deck] = addFrameLight(frameUniforms, cabinLightPos, warmWhite, lightConstant, 0.14f, 0.07f);
                 }
+                uploadFrameUniforms(frameUniforms);
                 
-                // Floor (pod.png)
-                Mat4 elevFloor = Mat4::translate(Vec3(ELEVATOR_X, elevator.y, ELEVATOR_Z)) * 
-                                Mat4::scale(Vec3(ELEVATOR_SIZE, 1.0f, ELEVATOR_SIZE));
-                setShaderMat4(shader3D, "uModel", elevFloor);
-                glBindTexture(GL_TEXTURE_2D, podTex);
-                glBindVertexArray(floorVAO);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+                // Walls, door, floor, ceiling and lamp of one cabin standing on baseY
+                auto drawCabinInterior = [&](float baseY, int light) {
+                    Mat4 cabinModel = Mat4::translate(Vec3(0.0f, baseY, 0.0f));
+                    float cabinAmbient = 0.2f;                 // Low ambient for realistic lighting
+                    setQueueLight(renderQueue, light);
                 
-                // Ceiling (metal)
-                Mat4 elevCeiling = Mat4::translate(Vec3(ELEVATOR_X, elevator.y + ELEVATOR_SIZE, ELEVATOR_Z)) * 
-                                  Mat4::rotateX(PI) * Mat4::scale(Vec3(ELEVATOR_SIZE, 1.0f, ELEVATOR_SIZE));
-                setShaderMat4(shader3D, "uModel", elevCeiling);
-                glBindTexture(GL_TEXTURE_2D, elevatorWallTex);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+                    // Metal walls and ceiling, the door based on its state (person can see open door texture)
+                    // and the floor (pod.png)
+                    drawRange(RENDER_OPAQUE, LAYER_METAL, building.cabinInterior, cabinAmbient, cabinModel);
+                    drawRange(RENDER_TRANSPARENT, elevator.doorsOpen ? LAYER_DOOR_OPEN : LAYER_DOOR_CLOSED,
+                              building.cabinInteriorDoor, cabinAmbient, cabinModel);
+                    drawRange(RENDER_TRANSPARENT, LAYER_POD, building.cabinFloor, cabinAmbient, cabinModel);
                 
-                // ========== RENDER CEILING LIGHT IN ELEVATOR (centered on ceiling, half scale) ==========
-                float elevatorLightScale = 0.6f;  // Half of the 1.2f used for floor lights
-                Mat4 elevatorLightModel = Mat4::translate(Vec3(ELEVATOR_X, elevator.y + ELEVATOR_SIZE - 0.5f, ELEVATOR_Z)) *
-                                         Mat4::rotateY(PI/2) *
-                                         Mat4::scale(Vec3(elevatorLightScale, elevatorLightScale, elevatorLightScale));
-                
-                // Disable blending for opaque rendering of the lamp
-                glDisable(GL_BLEND);
-                
-                glUseProgram(shader3D);
-                setShaderMat4(shader3D, "uModel", elevatorLightModel);
-                setShaderMat4(shader3D, "uView", view);
-                setShaderMat4(shader3D, "uProjection", projection);
-                setShaderVec3(shader3D, "uLightPos", elevatorLightPos);
-                setShaderVec3(shader3D, "uViewPos", camera.position);
-                setShaderVec3(shader3D, "uLightColor", Vec3(1.0f, 0.95f, 0.9f));
-                setShaderFloat(shader3D, "uAmbientStrength", 0.9f); 
-                setShaderFloat(shader3D, "uConstant", lightConstant);
-                setShaderFloat(shader3D, "uLinear", 0.14f);
-                setShaderFloat(shader3D, "uQuadratic", 0.07f);
-                setShaderFloat(shader3D, "uAlpha", 1.0f);
-                setButtonLightUniforms(shader3D);
-                
-                if (ceilingLight.texture > 0) {
-                    glActiveTexture(GL_TEXTURE0);
-                    glBindTexture(GL_TEXTURE_2D, ceilingLight.texture);
+                    // ========== RENDER CEILING LIGHT IN ELEVATOR (centered on ceiling, half scale) ==========
+                    float elevatorLightScale = 0.6f;  // Half of the 1.2f used for floor lights
+                    Mat4 elevatorLightModel = Mat4::translate(Vec3(ELEVATOR_X, baseY + ELEVATOR_SIZE - 0.5f, ELEVATOR_Z)) *
+                                             Mat4::rotateY(PI/2) *
+                                             Mat4::scale(Vec3(elevatorLightScale, elevatorLightScale, elevatorLightScale));
+                    drawModel(RENDER_OPAQUE, ceilingLight, 0.9f, elevatorLightModel);
+                };
+                for (int deck = 0; deck < elevator.decks; deck++) {
+                    drawCabinInterior(elevator.y + deck * FLOOR_HEIGHT, cabinLights[deck]);
                 }
                 
-                glBindVertexArray(ceilingLight.VAO);
-                glDrawArrays(GL_TRIANGLES, 0, ceilingLight.vertexCount);
-                glBindVertexArray(0);
-
-                // Re-enable blending for other objects
-                glEnable(GL_BLEND);
-                
                 // ========== RENDER BUTTONS ON LEFT WALL ==========
-                glBindVertexArray(wallVAO);
+                // Lit by the lamp of the person's cabin
+                setQueueLight(renderQueue, cabinLights[person.deck]);
                 
                 for (size_t i = 0; i < buttons.size(); i++) {
                     auto& btn = buttons[i];
                     // Button position on the panel surface
                     Vec3 btnWorldPos(ELEVATOR_X - ELEVATOR_SIZE/2 + 0.025f,  // On panel surface
-                                    elevator.y + btn.position.y, 
+                                    personCabinBase + btn.position.y, 
                                     ELEVATOR_Z + btn.position.z);
                     
-                    // Button texture
-                    glUseProgram(shader3D);
-                    Mat4 btnModel = Mat4::translate(btnWorldPos) * 
-                                   Mat4::rotateY(PI/2) * Mat4::scale(Vec3(btn.width, btn.height, 1.0f));
-                    setShaderMat4(shader3D, "uModel", btnModel);
-                    setShaderMat4(shader3D, "uView", view);
-                    setShaderMat4(shader3D, "uProjection", projection);
-                    setShaderVec3(shader3D, "uLightPos", elevatorLightPos);
-                    setShaderVec3(shader3D, "uViewPos", camera.position);
-                    setShaderVec3(shader3D, "uLightColor", Vec3(1.0f, 0.95f, 0.9f));
+                    // Button face from its layer of the array
+                    Mat4 btnModel = Mat4::placement(btnWorldPos, PI/2, Vec3(btn.width, btn.height, 1.0f));
                     // Pressed buttons glow brighter (higher ambient)
-                    setShaderFloat(shader3D, "uAmbientStrength", btn.isPressed ? 0.9f : 0.3f);
-                    setShaderFloat(shader3D, "uConstant", lightConstant);
-                    setShaderFloat(shader3D, "uLinear", 0.14f);
-                    setShaderFloat(shader3D, "uQuadratic", 0.07f);
-                    setShaderFloat(shader3D, "uAlpha", 1.0f);
-                    setButtonLightUniforms(shader3D);
-                    
-                    glBindTexture(GL_TEXTURE_2D, btn.texture);
-                    glBindVertexArray(wallVAO);
-                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+                    addInstance(buttonBatch, btnModel, btn.isPressed ? 0.9f : 0.3f, btn.material);
                 }
+                submitInstances(renderQueue, RENDER_TRANSPARENT, instancedShader3D, buttonBatch, buttonFaces);
             }
 
+            flushRenderQueue(renderQueue, frameUniforms);
+            setBlend(true);     // The 2D overlay blends
+
             // Render crosshair (2D overlay)
-            glDisable(GL_DEPTH_TEST);
+            setDepthTest(false);
             renderQuad(VAO2D, crosshairTex, shader2D, 0.0f, 0.0f, 0.05f, 0.05f * aspect, 0.7f);
             
             // Render status overlay in top-left corner
@@ -720,23 +814,43 @@ int main()
             
             // Restore depth test state based on toggle
             if (depthTestEnabled) {
-                glEnable(GL_DEPTH_TEST);
+                setDepthTest(true);
             }
 
             glfwSwapBuffers(window);
+            framesDrawn++;
         }
 
         glfwPollEvents();
     }
 
-    glDeleteVertexArrays(1, &floorVAO);
+    deleteRenderQueue(renderQueue);
+    deleteInstanceBatch(buildingDraws);
+    deleteBuildingGeometry(building);
     glDeleteVertexArrays(1, &wallVAO);
     glDeleteVertexArrays(1, &cubeVAO);
     glDeleteVertexArrays(1, &VAO2D);
-    glDeleteProgram(shader3D);
-    glDeleteProgram(colorShader3D);
-    glDeleteProgram(shader2D);
-    glDeleteProgram(colorShader2D);
+    deleteShaderProgram(shader3D);
+    deleteShaderProgram(colorShader3D);
+    deleteShaderProgram(layeredShader3D);
+    deleteShaderProgram(instancedShader3D);
+    deleteInstanceBatch(buttonBatch);
+    for (int i = 0; i < 3; i++) {
+        if (plants[i]->VAO != 0) deleteInstanceBatch(plantBatches[i]);
+    }
+    deleteInstanceBatch(waitingBatch);
+    glDeleteTextures(1, &buttonFaces);
+    glDeleteTextures(1, &plantTextures);
+    glDeleteTextures(1, &buildingTextures);
+    deleteFrameUniforms(frameUniforms);
+    deleteButtonLights(buttonLights);
+    deleteShaderProgram(shader2D);
+    deleteShaderProgram(colorShader2D);
+
+    if (globalReplay) closeTrace(replay.trace);
+    printGLStateStats(framesDrawn);
+    if (renderQueue.indirectCalls > 0)
+        std::cout << "Indirect: " << renderQueue.indirectDraws << " draws in " << renderQueue.indirectCalls << " calls" << std::endl;
 
     glfwDestroyWindow(window);
     glfwTerminate();
@@ -761,10 +875,10 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
     if (key == GLFW_KEY_T && action == GLFW_PRESS) {
         depthTestEnabled = !depthTestEnabled;
         if (depthTestEnabled) {
-            glEnable(GL_DEPTH_TEST);
+            setDepthTest(true);
             std::cout << "Depth Test: ON" << std::endl;
         } else {
-            glDisable(GL_DEPTH_TEST);
+            setDepthTest(false);
             std::cout << "Depth Test: OFF" << std::endl;
         }
     }
@@ -773,14 +887,29 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
     if (key == GLFW_KEY_F && action == GLFW_PRESS) {
         cullFaceEnabled = !cullFaceEnabled;
         if (cullFaceEnabled) {
-            glEnable(GL_CULL_FACE);
+            setCullFace(true);
             std::cout << "Back-Face Culling: ON" << std::endl;
         } else {
-            glDisable(GL_CULL_FACE);
+            setCullFace(false);
             std::cout << "Back-Face Culling: OFF" << std::endl;
         }
     }
     
+    // Replay controls - the recorded car can't be called
+    if (globalReplay) {
+        Replay& replay = *globalReplay;
+        if (action == GLFW_PRESS || action == GLFW_REPEAT) {
+            float step = (mods & GLFW_MOD_SHIFT) ? 3600.0f : 10.0f;
+            if (key == GLFW_KEY_RIGHT) replay.time = std::min(replay.time + step, traceDuration(replay.trace));
+            if (key == GLFW_KEY_LEFT) replay.time = std::max(0.0f, replay.time - step);
+            if (key == GLFW_KEY_UP) replay.speed = std::min(replay.speed * 2.0f, 4096.0f);
+            if (key == GLFW_KEY_DOWN) replay.speed = std::max(replay.speed / 2.0f, 0.25f);
+            if (key == GLFW_KEY_SPACE && action == GLFW_PRESS) replay.paused = !replay.paused;
+            replay.shownSecond = -1;
+        }
+        return;
+    }
+
     // Call elevator with C key (opens doors if elevator is on same floor)
     // Person must be near the elevator corner area to call it
     if (key == GLFW_KEY_C && action == GLFW_PRESS && globalElevator && globalPerson) {
@@ -796,9 +925,11 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
                                 globalPerson->position.z > elevMinZ && globalPerson->position.z < elevMaxZ);
             
             if (nearElevator) {
-                if (globalElevator->currentFloor != globalPerson->currentFloor) {
-                    // Call elevator to this floor
-                    addFloorToQueue(*globalElevator, globalPerson->currentFloor);
+                if (globalElevator->currentFloor != stopFloorFor(*globalElevator, globalPerson->currentFloor)) {
+                    // Call elevator to this floor - a nearly full car passes the call by
+                    if (!addHallCall(*globalElevator, stopFloorFor(*globalElevator, globalPerson->currentFloor))) {
+                        std::cout << "Elevator is full, hall call bypassed" << std::endl;
+                    }
                 } else {
                     // Elevator is here - open doors if they're closed
                     if (!globalElevator->doorsOpen && !globalElevator->moving) {
@@ -834,7 +965,7 @@ void mouseCallback(GLFWwindow* window, double xpos, double ypos)
 void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 {
     if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS && globalElevator && globalPerson && globalButtons) {
-        if (!globalPerson->inElevator) return;
+        if (!globalPerson->inElevator || globalReplay) return;
 
         Vec3 rayDir = camera.getForward();
         Vec3 rayOrigin = camera.position;
@@ -844,7 +975,7 @@ void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 
         for (auto& btn : *globalButtons) {
             Vec3 btnWorldPos(ELEVATOR_X - ELEVATOR_SIZE/2 + 0.025f,  // Match button render position
-                            globalElevator->y + btn.position.y, 
+                            globalElevator->y + globalPerson->deck * FLOOR_HEIGHT + btn.position.y, 
                             ELEVATOR_Z + btn.position.z);
             
             float planeX = btnWorldPos.x;
@@ -863,7 +994,7 @@ void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 
         if (hitButton) {
             if (hitButton->floorNumber >= 0 && hitButton->floorNumber <= 7) {
-                addFloorToQueue(*globalElevator, hitButton->floorNumber);
+                addFloorToQueue(*globalElevator, stopFloorFor(*globalElevator, hitButton->floorNumber));
                 hitButton->isPressed = true;
             }
             else if (hitButton->floorNumber == -1) {
@@ -894,7 +1025,7 @@ void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
                     if (nearestFloor >= NUM_FLOORS) nearestFloor = NUM_FLOORS - 1;
                     
                     // Add nearest floor to queue so elevator goes there
-                    addFloorToQueue(*globalElevator, nearestFloor);
+                    addFloorToQueue(*globalElevator, stopFloorFor(*globalElevator, nearestFloor));
                 }
                 
                 ventilationActive = false;
@@ -912,69 +1043,73 @@ void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
     }
 }
 
-float getFloorYPosition(int floor)
-{
-    return floor * FLOOR_HEIGHT;
-}
-
 void updateElevator(Elevator& elevator, Person& person, float deltaTime)
 {
-    // Door timer - runs whenever doors are open
-    if (elevator.doorsOpen) {
-        elevator.doorTimer += deltaTime;
-        
-        float doorOpenTime = elevator.doorExtendUsed ? 10.0f : 5.0f;
-        
-        if (elevator.doorTimer >= doorOpenTime) {
-            elevator.doorsOpen = false;
-            elevator.doorTimer = 0.0f;
-            elevator.doorExtendUsed = false;
-        }
-    }
+    bool arrived = stepElevator(elevator, deltaTime);
 
-    // Start moving to next floor in queue
-    if (!elevator.queuedFloors.empty() && !elevator.moving && !elevator.doorsOpen) {
-        elevator.targetFloor = elevator.queuedFloors[0];
-        elevator.queuedFloors.erase(elevator.queuedFloors.begin());
-        elevator.moving = true;
+    // Update person position if in elevator
+    if (person.inElevator && (elevator.moving || arrived)) {
+        person.position.y = elevator.y + person.deck * FLOOR_HEIGHT + 1.7f;
     }
 
-    // Elevator movement
-    if (elevator.moving && !elevator.doorsOpen) {
-        float targetY = getFloorYPosition(elevator.targetFloor);
-        float direction = (targetY > elevator.y) ? 1.0f : -1.0f;
-        elevator.y += direction * elevator.speed * deltaTime;
-
-        // Update person position if in elevator
-        if (person.inElevator) {
-            person.position.y = elevator.y + 1.7f;
+    if (arrived) {
+        if (ventilationActive) {
+            ventilationActive = false;
         }
 
-        // Reached target floor
-        if (std::abs(elevator.y - targetY) < 0.1f) {
-            elevator.y = targetY;
-            elevator.currentFloor = elevator.targetFloor;
-            elevator.moving = false;
-            elevator.doorsOpen = true;           // Open doors when arriving
-            elevator.doorTimer = 0.0f;           // Reset timer
-            elevator.doorExtendUsed = false;     // Reset extension flag
-            
-            if (ventilationActive) {
-                ventilationActive = false;
-            }
-            
-            // Unpress button for current floor
-            if (globalButtons) {
-                for (auto& btn : *globalButtons) {
-                    if (btn.floorNumber == elevator.currentFloor) {
-                        btn.isPressed = false;
-                    }
+        // Unpress button for current floor
+        if (globalButtons) {
+            for (auto& btn : *globalButtons) {
+                if (btn.floorNumber >= 0 && stopFloorFor(elevator, btn.floorNumber) == elevator.currentFloor) {
+                    btn.isPressed = false;
                 }
             }
         }
     }
 }
 
+void updateReplay(Replay& replay, Elevator& elevator, Person& person, float deltaTime)
+{
+    if (!replay.paused) replay.time = std::min(replay.time + deltaTime * replay.speed, traceDuration(replay.trace));
+    seekTrace(replay.trace, replay.time);
+    for (int k = 0; k < (int)replay.cars.size(); k++) applyTraceCar(replay.trace.frame.cars[k], replay.cars[k]);
+    const TraceCar& car = replay.trace.frame.cars[replay.car];
+    applyTraceCar(car, elevator);
+
+    if (person.inElevator) {
+        person.position.y = elevator.y + person.deck * FLOOR_HEIGHT + 1.7f;
+    }
+
+    // Floor buttons light up for the recorded car's stops
+    if (globalButtons) {
+        for (auto& btn : *globalButtons) {
+            if (btn.floorNumber >= 0) btn.isPressed = traceStopsAt(car, stopFloorFor(elevator, btn.floorNumber));
+        }
+    }
+}
+
+// Where the replayed car in "slot" stands relative to the scene's shaft: slot 0 is
+// that shaft, the next ones line up to its left along the back wall and start a
+// row further forward once the wall is full
+Vec3 replayShaftOffset(int slot)
+{
+    const float pitch = ELEVATOR_SIZE + 0.2f;
+    int perRow = std::max(1, (int)(FLOOR_WIDTH / pitch));
+    return Vec3(-(slot % perRow) * pitch, 0.0f, (slot / perRow) * (ELEVATOR_SIZE + 4.0f));
+}
+
+void showReplayTime(GLFWwindow* window, Replay& replay)
+{
+    int second = (int)(replay.trace.header.startTimeOfDay + replay.time) % 86400;
+    if (second == replay.shownSecond) return;
+    replay.shownSecond = second;
+
+    char title[128];
+    snprintf(title, sizeof(title), "3D Elevator Simulator - replay %02d:%02d:%02d x%g%s", second / 3600, second / 60 % 60, second % 60,
+             replay.speed, replay.paused ? " (paused)" : "");
+    glfwSetWindowTitle(window, title);
+}
+
 void updateCamera(Camera& camera, Person& person, float deltaTime)
 {
     Vec3 forward = Vec3(sin(camera.yaw), 0, cos(camera.yaw));
@@ -1001,7 +1136,8 @@ void updateCamera(Camera& camera, Person& person, float deltaTime)
             // Can only exit if doors are open and elevator is not moving
             if (globalElevator && globalElevator->doorsOpen && !globalElevator->moving && newPos.z > elevMaxZ) {
                 person.inElevator = false;
-                person.currentFloor = globalElevator->currentFloor;
+                alightElevator(*globalElevator, person.weightKg, person.deck);
+                person.currentFloor = globalElevator->currentFloor + person.deck;
                 newPos.y = getFloorYPosition(person.currentFloor) + 1.7f;
                 newPos.z = ELEVATOR_Z + ELEVATOR_SIZE/2 + 1.0f;
             }
@@ -1026,7 +1162,7 @@ void updateCamera(Camera& camera, Person& person, float deltaTime)
             if (newPos.z < -FLOOR_DEPTH/2 + margin) newPos.z = -FLOOR_DEPTH/2 + margin;
             
             // Elevator collision - block movement into elevator area if elevator is on same floor
-            if (globalElevator && globalElevator->currentFloor == person.currentFloor) {
+            if (globalElevator && globalElevator->currentFloor == stopFloorFor(*globalElevator, person.currentFloor)) {
                 float elevMargin = 0.3f;
                 float elevMinX = ELEVATOR_X - ELEVATOR_SIZE/2 - elevMargin;
                 float elevMaxX = ELEVATOR_X + ELEVATOR_SIZE/2 + elevMargin;
@@ -1041,12 +1177,15 @@ void updateCamera(Camera& camera, Person& person, float deltaTime)
                     // Check if doors are open - can enter through front door only
                     bool inFrontOfDoor = (newPos.z > ELEVATOR_Z + ELEVATOR_SIZE/2 - 0.5f);
                     
-                    if (globalElevator->doorsOpen && !globalElevator->moving && inFrontOfDoor) {
-                        // Can enter elevator through open doors
+                    // Can enter elevator through open doors, unless the car is already at rated load
+                    int deck = deckFor(*globalElevator, person.currentFloor);
+                    if (globalElevator->doorsOpen && !globalElevator->moving && inFrontOfDoor &&
+                        boardElevator(*globalElevator, person.weightKg, deck)) {
                         person.inElevator = true;
+                        person.deck = deck;
                         newPos.x = ELEVATOR_X;
                         newPos.z = ELEVATOR_Z;
-                        newPos.y = globalElevator->y + 1.7f;
+                        newPos.y = globalElevator->y + deck * FLOOR_HEIGHT + 1.7f;
                     } else {
                         // Blocked by elevator - revert to old position
                         // Calculate collision normal and slide along it
@@ -1112,18 +1251,3 @@ void updateCamera(Camera& camera, Person& person, float deltaTime)
     
     camera.position = person.position;
 }
-
-void addFloorToQueue(Elevator& elevator, int floor)
-{
-    if (floor == elevator.currentFloor && !elevator.moving) {
-        if (!elevator.doorsOpen) {
-            elevator.doorsOpen = true;
-            elevator.doorTimer = 0.0f;
-        }
-        return;
-    }
-    
-    if (std::find(elevator.queuedFloors.begin(), elevator.queuedFloors.end(), floor) == elevator.queuedFloors.end()) {
-        elevator.queuedFloors.push_back(floor);
-    }
-}
\ No newline at end of file
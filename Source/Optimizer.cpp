@@ -0,0 +1,236 @@
+#include "../Header/Optimizer.h"
+#include "../Header/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+OptimizerSpec defaultOptimizerSpec()
+{
+    OptimizerSpec spec;
+    spec.generations = 30;
+    spec.population = 24;
+    spec.eliteCount = 2;
+    spec.tournamentSize = 3;
+    spec.mutationRate = 0.3f;
+    spec.mutationSigma = 0.1f;
+    spec.duration = 3600.0f;
+    spec.timeStep = 1.0f / 75.0f;
+    spec.seedsPerScenario = 3;
+    spec.threads = 0;
+    spec.seed = 99;
+    return spec;
+}
+
+std::vector<SimConfig> optimizerScenarios()
+{
+    std::vector<SimConfig> scenarios;
+
+    SimConfig upPeak = defaultSimConfig();
+    scenarios.push_back(upPeak);
+
+    SimConfig heavy = defaultSimConfig();
+    heavy.traffic.arrivalsPerMinute = 18.0f;
+    heavy.seed = 2;
+    scenarios.push_back(heavy);
+
+    SimConfig downPeak = defaultSimConfig();
+    downPeak.traffic.lobbyOriginShare = 0.1f;
+    downPeak.traffic.lobbyDestinationShare = 0.8f;
+    downPeak.startTimeOfDay = 17.0f * 3600.0f;
+    downPeak.seed = 3;
+    scenarios.push_back(downPeak);
+
+    SimConfig interfloor = defaultSimConfig();
+    interfloor.numCars = 3;
+    interfloor.traffic.lobbyOriginShare = 0.1f;
+    interfloor.traffic.lobbyDestinationShare = 0.1f;
+    interfloor.startTimeOfDay = 11.0f * 3600.0f;
+    interfloor.seed = 4;
+    scenarios.push_back(interfloor);
+
+    SimConfig tower = zonedTowerConfig(60);
+    tower.traffic.arrivalsPerMinute = 90.0f;
+    tower.seed = 5;
+    scenarios.push_back(tower);
+    return scenarios;
+}
+
+typedef std::vector<float> Genome;
+
+static void genomeToWeights(const Genome& genome, DispatchParams weights[TRAFFIC_MODE_COUNT])
+{
+    for (int mode = 0; mode < TRAFFIC_MODE_COUNT; mode++) {
+        weights[mode].travelWeight = 1.0f;
+        weights[mode].stopWeight = genome[2 * mode];
+        weights[mode].loadWeight = genome[2 * mode + 1];
+    }
+}
+
+static Genome weightsToGenome(const DispatchParams weights[TRAFFIC_MODE_COUNT])
+{
+    Genome genome(OPTIMIZER_GENES);
+    for (int mode = 0; mode < TRAFFIC_MODE_COUNT; mode++) {
+        genome[2 * mode] = weights[mode].stopWeight / weights[mode].travelWeight;
+        genome[2 * mode + 1] = weights[mode].loadWeight / weights[mode].travelWeight;
+    }
+    return genome;
+}
+
+// Runs every candidate on every scenario - one pool job per run
+static std::vector<SimStats> runCandidates(ThreadPool& pool, const std::vector<Genome>& candidates,
+                                           const std::vector<SimConfig>& scenarios, const OptimizerSpec& spec)
+{
+    int numScenarios = (int)scenarios.size();
+    std::vector<SimStats> stats(candidates.size() * numScenarios);
+    runJobs(pool, (int)stats.size(), [&](int job) {
+        SimConfig config = scenarios[job % numScenarios];
+        genomeToWeights(candidates[job / numScenarios], config.dispatchByMode);
+        stats[job] = runSimulation(config, spec.duration, spec.timeStep);
+    });
+    return stats;
+}
+
+static float candidateScore(const SimStats* stats, const SimStats* baseline, int numScenarios)
+{
+    float score = 0.0f;
+    for (int s = 0; s < numScenarios; s++) {
+        float wait = averageWaitTime(stats[s]) / std::max(0.1f, averageWaitTime(baseline[s]));
+        float maxWait = stats[s].maxWaitTime / std::max(0.1f, baseline[s].maxWaitTime);
+        score += (1.0f - OPTIMIZER_MAX_WAIT_SHARE) * wait + OPTIMIZER_MAX_WAIT_SHARE * maxWait;
+    }
+    return score / numScenarios;
+}
+
+void optimizeDispatchWeights(const OptimizerSpec& spec, const char* outputPath, DispatchParams best[TRAFFIC_MODE_COUNT])
+{
+    // Every scenario with several traffic seeds, so a candidate is not scored on one lucky arrival sequence
+    std::vector<SimConfig> scenarios;
+    for (const SimConfig& scenario : optimizerScenarios()) {
+        for (int s = 0; s < std::max(1, spec.seedsPerScenario); s++) {
+            scenarios.push_back(scenario);
+            scenarios.back().seed = scenario.seed + s * 1000;
+        }
+    }
+    int numScenarios = (int)scenarios.size();
+    std::mt19937 rng(spec.seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::normal_distribution<float> noise(0.0f, spec.mutationSigma * OPTIMIZER_WEIGHT_MAX);
+
+    ThreadPool pool;
+    startThreadPool(pool, spec.threads);
+    auto start = std::chrono::steady_clock::now();
+
+    // The hand-tuned weights are the yardstick and the first candidate
+    SimConfig reference = defaultSimConfig();
+    Genome handTuned = weightsToGenome(reference.dispatchByMode);
+    std::vector<SimStats> baseline = runCandidates(pool, std::vector<Genome>(1, handTuned), scenarios, spec);
+
+    std::vector<Genome> population(1, handTuned);
+    while ((int)population.size() < spec.population) {
+        Genome genome(OPTIMIZER_GENES);
+        for (float& gene : genome) gene = unit(rng) * OPTIMIZER_WEIGHT_MAX;
+        population.push_back(genome);
+    }
+    std::vector<float> scores(population.size(), 0.0f);
+    int scored = 0;     // Elites at the front keep their score from the last generation
+
+    for (int generation = 0; generation < spec.generations; generation++) {
+        std::vector<Genome> fresh(population.begin() + scored, population.end());
+        std::vector<SimStats> stats = runCandidates(pool, fresh, scenarios, spec);
+        for (size_t i = 0; i < fresh.size(); i++) {
+            scores[scored + i] = candidateScore(&stats[i * numScenarios], baseline.data(), numScenarios);
+        }
+
+        std::vector<int> order(population.size());
+        for (int i = 0; i < (int)order.size(); i++) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](int a, int b) { return scores[a] < scores[b]; });
+
+        genomeToWeights(population[order[0]], best);
+        for (int mode = 0; mode < TRAFFIC_MODE_COUNT; mode++) best[mode].returnToLobby = reference.dispatchByMode[mode].returnToLobby;
+        if (outputPath) saveDispatchWeights(outputPath, best);
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Generation " << generation + 1 << ": best " << scores[order[0]] << ", median " << scores[order[order.size() / 2]]
+                  << " (" << seconds << " s)" << std::endl;
+
+        // Next generation: elites, then children of tournament winners
+        std::vector<Genome> next;
+        std::vector<float> nextScores;
+        for (int i = 0; i < spec.eliteCount && i < (int)order.size(); i++) {
+            next.push_back(population[order[i]]);
+            nextScores.push_back(scores[order[i]]);
+        }
+        scored = (int)next.size();
+
+        auto tournament = [&]() {
+            int winner = (int)(rng() % population.size());
+            for (int k = 1; k < spec.tournamentSize; k++) {
+                int rival = (int)(rng() % population.size());
+                if (scores[rival] < scores[winner]) winner = rival;
+            }
+            return winner;
+        };
+        while ((int)next.size() < spec.population) {
+            const Genome& a = population[tournament()];
+            const Genome& b = population[tournament()];
+            Genome child(OPTIMIZER_GENES);
+            for (int g = 0; g < OPTIMIZER_GENES; g++) {
+                // Blend crossover: anywhere in the parents' interval widened by half its length
+                float low = std::min(a[g], b[g]), high = std::max(a[g], b[g]);
+                float spread = 0.5f * (high - low);
+                child[g] = low - spread + unit(rng) * (high - low + 2.0f * spread);
+                if (unit(rng) < spec.mutationRate) child[g] += noise(rng);
+                child[g] = std::min(OPTIMIZER_WEIGHT_MAX, std::max(0.0f, child[g]));
+            }
+            next.push_back(child);
+        }
+        population.swap(next);
+        nextScores.resize(population.size(), 0.0f);
+        scores.swap(nextScores);
+    }
+    stopThreadPool(pool);
+}
+
+bool saveDispatchWeights(const char* path, const DispatchParams weights[TRAFFIC_MODE_COUNT])
+{
+    std::ofstream file(path);
+    if (!file) return false;
+    file << "# pattern travelWeight stopWeight loadWeight returnToLobby" << std::endl;
+    for (int mode = 0; mode < TRAFFIC_MODE_COUNT; mode++) {
+        const DispatchParams& w = weights[mode];
+        file << trafficModeName((TrafficMode)mode) << ' ' << w.travelWeight << ' ' << w.stopWeight << ' ' << w.loadWeight << ' '
+             << (w.returnToLobby ? 1 : 0) << std::endl;
+    }
+    return true;
+}
+
+bool loadDispatchWeights(const char* path, DispatchParams weights[TRAFFIC_MODE_COUNT])
+{
+    std::ifstream file(path);
+    if (!file) return false;
+
+    bool found = false;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string name;
+        DispatchParams w;
+        int returnToLobby;
+        if (!(fields >> name >> w.travelWeight >> w.stopWeight >> w.loadWeight >> returnToLobby)) continue;
+        w.returnToLobby = returnToLobby != 0;
+        for (int mode = 0; mode < TRAFFIC_MODE_COUNT; mode++) {
+            if (name == trafficModeName((TrafficMode)mode)) {
+                weights[mode] = w;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
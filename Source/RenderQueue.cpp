@@ -0,0 +1,195 @@
+#include "../Header/RenderQueue.h"
+#include "../Header/GLState.h"
+
+#include <algorithm>
+#include <cstring>
+
+void beginRenderQueue(RenderQueue& queue, const Vec3& eye)
+{
+    queue.packets.clear();
+    queue.eye = eye;
+    queue.light = 0;
+}
+
+bool enableIndirectDraws(RenderQueue& queue, const ShaderProgram& program, InstanceBatch& perDraw)
+{
+    if (!GLEW_VERSION_4_3 && !(GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance)) return false;
+    queue.indirect = true;
+    queue.indirectProgram = &program;
+    queue.perDraw = &perDraw;
+    glGenBuffers(1, &queue.commandBuffer);
+    return true;
+}
+
+void deleteRenderQueue(RenderQueue& queue)
+{
+    if (queue.commandBuffer != 0) glDeleteBuffers(1, &queue.commandBuffer);
+    queue.commandBuffer = 0;
+    queue.indirect = false;
+    queue.packets.clear();
+}
+
+void setQueueLight(RenderQueue& queue, int light)
+{
+    queue.light = light;
+}
+
+// Bits of a non-negative float order the same way as its value
+static uint32_t depthBits(float depth)
+{
+    uint32_t bits;
+    memcpy(&bits, &depth, sizeof(bits));
+    return bits;
+}
+
+static void submitPacket(RenderQueue& queue, RenderPass pass, DrawPacket& packet, const Vec3& position)
+{
+    uint64_t depth = depthBits((position - queue.eye).length());
+    uint64_t light = (uint64_t)queue.light & 0x3;
+    uint64_t programBits = packet.program->id & 0xFF;
+    unsigned int texture = packet.texture;
+    unsigned int vertexArray = packet.vertexArray;
+
+    if (pass == RENDER_OPAQUE) {
+        packet.key = light << 61 | programBits << 53 | (uint64_t)(texture & 0x7FF) << 42 |
+                     (uint64_t)(vertexArray & 0x3FF) << 32 | depth;
+    } else {
+        uint64_t farFirst = ~depth & 0x7FFFFFFF;
+        packet.key = 1ull << 63 | farFirst << 32 | light << 30 | programBits << 22 |
+                     (uint64_t)(texture & 0xFFF) << 10 | (vertexArray & 0x3FF);
+    }
+    queue.packets.push_back(packet);
+}
+
+static DrawPacket makePacket(const RenderQueue& queue, const ShaderProgram& program, unsigned int vertexArray,
+                             unsigned int texture, float ambient, const Mat4& model)
+{
+    DrawPacket packet;
+    packet.program = &program;
+    packet.vertexArray = vertexArray;
+    packet.texture = texture;
+    packet.layer = -1;
+    packet.first = 0;
+    packet.count = 0;
+    packet.indexed = true;
+    packet.light = queue.light;
+    packet.batch = NULL;
+    packet.indirectSlot = -1;
+    packet.ambient = ambient;
+    packet.model = model;
+    return packet;
+}
+
+void submitDraw(RenderQueue& queue, RenderPass pass, const ShaderProgram& program, unsigned int vertexArray,
+                unsigned int texture, int count, bool indexed, float ambient, const Mat4& model)
+{
+    DrawPacket packet = makePacket(queue, program, vertexArray, texture, ambient, model);
+    packet.count = count;
+    packet.indexed = indexed;
+    // Distance from the eye to the object's origin
+    submitPacket(queue, pass, packet, Vec3(model.m[12], model.m[13], model.m[14]));
+}
+
+void submitRange(RenderQueue& queue, RenderPass pass, const ShaderProgram& program, unsigned int vertexArray,
+                 unsigned int texture, int layer, const DrawRange& range, float ambient, const Mat4& model)
+{
+    DrawPacket packet = makePacket(queue, program, vertexArray, texture, ambient, model);
+    packet.layer = layer;
+    packet.first = range.first;
+    packet.count = range.count;
+    // Baked ranges are only ever translated
+    Vec3 center = range.center + Vec3(model.m[12], model.m[13], model.m[14]);
+    submitPacket(queue, pass, packet, center);
+}
+
+void submitInstances(RenderQueue& queue, RenderPass pass, const ShaderProgram& program, InstanceBatch& batch,
+                     unsigned int texture)
+{
+    if (batch.instances.empty()) return;
+    const float* first = batch.instances[0].model;
+    DrawPacket packet = makePacket(queue, program, batch.vertexArray, texture, 0.0f, Mat4());
+    packet.batch = &batch;
+    submitPacket(queue, pass, packet, Vec3(first[12], first[13], first[14]));
+}
+
+static bool drawsIndirect(const RenderQueue& queue, const DrawPacket& packet)
+{
+    return queue.indirect && !packet.batch && packet.indexed && packet.layer >= 0 && (packet.key >> 63) == RENDER_OPAQUE &&
+           packet.vertexArray == queue.perDraw->vertexArray;
+}
+
+// One command and per-draw record for every indirect packet, in sorted order so
+// each run of them is a contiguous range of commands
+static void fillIndirectBuffers(RenderQueue& queue)
+{
+    queue.commands.clear();
+    queue.perDraw->instances.clear();
+    for (DrawPacket& packet : queue.packets) {
+        if (!drawsIndirect(queue, packet)) continue;
+        packet.indirectSlot = (int)queue.commands.size();
+        IndirectCommand command = {(uint32_t)packet.count, 1, (uint32_t)packet.first, 0, (uint32_t)packet.indirectSlot};
+        queue.commands.push_back(command);
+        addInstance(*queue.perDraw, packet.model, packet.ambient, packet.layer);
+    }
+    if (queue.commands.empty()) return;
+
+    uploadInstances(*queue.perDraw);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, queue.commandBuffer);
+    size_t bytes = queue.commands.size() * sizeof(IndirectCommand);
+    if ((int)queue.commands.size() > queue.commandCapacity) {
+        queue.commandCapacity = (int)queue.commands.size();
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, bytes, queue.commands.data(), GL_STREAM_DRAW);
+    } else {
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, queue.commandCapacity * sizeof(IndirectCommand), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, bytes, queue.commands.data());
+    }
+}
+
+void flushRenderQueue(RenderQueue& queue, const FrameUniforms& frame)
+{
+    std::sort(queue.packets.begin(), queue.packets.end(),
+              [](const DrawPacket& a, const DrawPacket& b) { return a.key < b.key; });
+    if (queue.indirect) fillIndirectBuffers(queue);
+
+    int light = -1;
+    size_t count = queue.packets.size();
+    for (size_t i = 0; i < count; i++) {
+        const DrawPacket& packet = queue.packets[i];
+        setBlend((packet.key >> 63) == RENDER_TRANSPARENT);
+        if (packet.light != light) {
+            light = packet.light;
+            useFrameLight(frame, light);
+        }
+        if (packet.batch || packet.layer >= 0) bindTextureArray(0, packet.texture);
+        else bindTexture2D(0, packet.texture);
+        bindVertexArray(packet.vertexArray);
+
+        if (packet.indirectSlot >= 0) {
+            // The run ends where the texture array or light pass changes
+            size_t end = i + 1;
+            while (end < count && queue.packets[end].indirectSlot >= 0 &&
+                   queue.packets[end].texture == packet.texture && queue.packets[end].light == packet.light) end++;
+
+            useProgram(queue.indirectProgram->id);
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                        (void*)(packet.indirectSlot * sizeof(IndirectCommand)), (GLsizei)(end - i), 0);
+            queue.indirectCalls++;
+            queue.indirectDraws += end - i;
+            i = end - 1;
+            continue;
+        }
+
+        useProgram(packet.program->id);
+        if (packet.batch) {
+            drawInstanceBatch(*packet.batch);
+            packet.batch->instances.clear();
+            continue;
+        }
+        setShaderMat4(*packet.program, U_MODEL, packet.model);
+        setShaderFloat(*packet.program, U_AMBIENT_STRENGTH, packet.ambient);
+        if (packet.layer >= 0) setShaderInt(*packet.program, U_LAYER, packet.layer);
+        if (packet.indexed) glDrawElements(GL_TRIANGLES, packet.count, GL_UNSIGNED_INT, (void*)(packet.first * sizeof(unsigned int)));
+        else glDrawArrays(GL_TRIANGLES, packet.first, packet.count);
+    }
+    queue.packets.clear();
+}
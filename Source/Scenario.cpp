@@ -0,0 +1,317 @@
+#include "../Header/Scenario.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+
+Scenario defaultScenario()
+{
+    Scenario scenario;
+    scenario.config = defaultSimConfig();
+    scenario.duration = 3600.0f;
+
+    const char* floorTextures[NUM_FLOORS] = {
+        "Resources/podrum.jpg", "Resources/prizemlje.jpg", "Resources/prviSprat.jpg", "Resources/drugiSprat.jpg",
+        "Resources/treciSprat.jpg", "Resources/cetvrtiSprat.jpg", "Resources/petiSprat.jpg", "Resources/sestiSprat.jpg"
+    };
+    for (int i = 0; i < NUM_FLOORS; i++) scenario.floorTextures[i] = floorTextures[i];
+
+    // Left column: floors 6 down to 1, right column: PR, SU, open, close, stop, ventilation
+    scenario.buttons = {
+        {1, 1, 0, "Resources/tasterSuteren.png"},
+        {1, 0, 1, "Resources/tasterPrizemlje.png"},
+        {0, 5, 2, "Resources/taster1.png"},
+        {0, 4, 3, "Resources/taster2.png"},
+        {0, 3, 4, "Resources/taster3.png"},
+        {0, 2, 5, "Resources/taster4.png"},
+        {0, 1, 6, "Resources/taster5.png"},
+        {0, 0, 7, "Resources/taster6.png"},
+        {1, 2, -1, "Resources/tasterOtvaranje.png"},
+        {1, 3, -2, "Resources/tasterZatvaranje.png"},
+        {1, 4, -3, "Resources/tasterStop.png"},
+        {1, 5, -4, "Resources/tasterVentilacija.png"}
+    };
+
+    scenario.carStartFloor = 2;
+    scenario.personStartFloor = 1;
+    scenario.bytesRead = 0;
+    return scenario;
+}
+
+struct ScenarioParser {
+    Scenario* scenario;
+    const char* path;
+    int line;
+    bool zonesGiven;
+    bool buttonsGiven;
+    bool inTrips;
+    bool sorted;
+};
+
+static void skipSpaces(const char*& p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+}
+
+static std::string_view nextToken(const char*& p, const char* end)
+{
+    skipSpaces(p, end);
+    const char* start = p;
+    while (p < end && *p != ' ' && *p != '\t') p++;
+    return std::string_view(start, p - start);
+}
+
+static bool parseInt(const char*& p, const char* end, int& value)
+{
+    skipSpaces(p, end);
+    auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) return false;
+    p = result.ptr;
+    return true;
+}
+
+static bool parseFloat(const char*& p, const char* end, float& value)
+{
+    skipSpaces(p, end);
+    auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) return false;
+    p = result.ptr;
+    return true;
+}
+
+static bool parseSwitch(const char*& p, const char* end, bool& value)
+{
+    std::string_view token = nextToken(p, end);
+    if (token == "on") value = true;
+    else if (token == "off") value = false;
+    else return false;
+    return true;
+}
+
+static bool fail(const ScenarioParser& parser, const char* message)
+{
+    std::cout << parser.path << ":" << parser.line << ": " << message << std::endl;
+    return false;
+}
+
+static bool isFloor(const ScenarioParser& parser, int floor)
+{
+    return floor >= 0 && floor < parser.scenario->config.numFloors;
+}
+
+// Hot path for pre-recorded passengers: "seconds origin destination [kg]"
+static bool parseTrip(ScenarioParser& parser, const char* p, const char* end)
+{
+    ScheduledTrip trip;
+    if (!parseFloat(p, end, trip.time) || !parseInt(p, end, trip.origin) || !parseInt(p, end, trip.destination)) {
+        return fail(parser, "expected: seconds origin destination [kg]");
+    }
+    trip.weightKg = 0.0f;
+    skipSpaces(p, end);
+    if (p < end && (!parseFloat(p, end, trip.weightKg) || trip.weightKg <= 0.0f)) return fail(parser, "bad passenger weight");
+    skipSpaces(p, end);
+    if (p < end) return fail(parser, "unexpected text after the trip");
+    if (!isFloor(parser, trip.origin) || !isFloor(parser, trip.destination)) return fail(parser, "trip floor outside the building");
+    // No car could ever take them, they would wait forever
+    if (trip.weightKg > parser.scenario->config.capacityKg) return fail(parser, "passenger heavier than the car capacity");
+
+    std::vector<ScheduledTrip>& trips = parser.scenario->trips;
+    if (!trips.empty() && trip.time < trips.back().time) parser.sorted = false;
+    trips.push_back(trip);
+    return true;
+}
+
+static bool parseSetting(ScenarioParser& parser, const char* p, const char* end)
+{
+    Scenario& scenario = *parser.scenario;
+    SimConfig& config = scenario.config;
+    std::string_view key = nextToken(p, end);
+    bool ok = true;
+
+    if (key == "floors") {
+        ok = parseInt(p, end, config.numFloors) && config.numFloors >= 2 && config.numFloors <= TRAFFIC_MAX_FLOORS;
+    } else if (key == "cars") {
+        ok = parseInt(p, end, config.numCars) && config.numCars >= 1;
+    } else if (key == "zone") {
+        if (!parser.zonesGiven) config.zones.clear();
+        parser.zonesGiven = true;
+        Zone zone;
+        ok = parseInt(p, end, zone.lowestFloor) && parseInt(p, end, zone.highestFloor) &&
+             parseInt(p, end, zone.lobbyFloor) && parseInt(p, end, zone.numCars) &&
+             zone.lowestFloor >= 0 && zone.lobbyFloor >= 0 && zone.lowestFloor <= zone.highestFloor && zone.numCars >= 1;
+        if (ok) config.zones.push_back(zone);
+    } else if (key == "decks") {
+        ok = parseInt(p, end, config.carDecks) && config.carDecks >= 1 && config.carDecks <= MAX_DECKS;
+    } else if (key == "cars_per_shaft") {
+        ok = parseInt(p, end, config.carsPerShaft) && config.carsPerShaft >= 1;
+    } else if (key == "speed") {
+        ok = parseFloat(p, end, config.carSpeed) && config.carSpeed > 0.0f;
+    } else if (key == "capacity") {
+        ok = parseInt(p, end, config.capacityPersons) && parseFloat(p, end, config.capacityKg) &&
+             config.capacityPersons > 0 && config.capacityKg > 0.0f;
+    } else if (key == "doors") {
+        ok = parseFloat(p, end, config.doorOpenTime) && parseFloat(p, end, config.doorExtendedTime) &&
+             config.doorOpenTime > 0.0f && config.doorExtendedTime >= config.doorOpenTime;
+    } else if (key == "traffic") {
+        TrafficProfile& traffic = config.traffic;
+        ok = parseFloat(p, end, traffic.arrivalsPerMinute) && parseInt(p, end, traffic.lobbyFloor) &&
+             parseFloat(p, end, traffic.lobbyOriginShare) && parseFloat(p, end, traffic.lobbyDestinationShare) &&
+             traffic.arrivalsPerMinute >= 0.0f && traffic.lobbyFloor >= 0;
+    } else if (key == "parking") {
+        std::string_view value = nextToken(p, end);
+        if (value == "none") config.parking = ParkingStrategy::None;
+        else if (value == "predicted") config.parking = ParkingStrategy::PredictedDemand;
+        else ok = false;
+    } else if (key == "assignment") {
+        std::string_view value = nextToken(p, end);
+        if (value == "greedy") config.assignment = AssignmentMethod::Greedy;
+        else if (value == "batch") config.assignment = AssignmentMethod::Batch;
+        else ok = false;
+    } else if (key == "adaptive") {
+        ok = parseSwitch(p, end, config.adaptiveDispatch);
+    } else if (key == "energy_saving") {
+        ok = parseSwitch(p, end, config.energySaving);
+    } else if (key == "start") {
+        int hours = 0, minutes = 0;
+        ok = parseInt(p, end, hours);
+        if (ok && p < end && *p == ':') ok = parseInt(++p, end, minutes);
+        ok = ok && hours >= 0 && hours < 24 && minutes >= 0 && minutes < 60;
+        config.startTimeOfDay = hours * 3600.0f + minutes * 60.0f;
+    } else if (key == "seed") {
+        int seed;
+        ok = parseInt(p, end, seed);
+        config.seed = (unsigned int)seed;
+    } else if (key == "duration") {
+        ok = parseFloat(p, end, scenario.duration) && scenario.duration > 0.0f;
+        scenario.duration *= 60.0f;
+    } else if (key == "car_floor") {
+        ok = parseInt(p, end, scenario.carStartFloor) && scenario.carStartFloor >= 0 && scenario.carStartFloor < NUM_FLOORS;
+    } else if (key == "person_floor") {
+        ok = parseInt(p, end, scenario.personStartFloor) && scenario.personStartFloor >= 0 && scenario.personStartFloor < NUM_FLOORS;
+    } else if (key == "floor_texture") {
+        int floor;
+        ok = parseInt(p, end, floor) && floor >= 0 && floor < NUM_FLOORS;
+        std::string_view texture = nextToken(p, end);
+        ok = ok && !texture.empty();
+        if (ok) scenario.floorTextures[floor] = std::string(texture);
+    } else if (key == "button") {
+        if (!parser.buttonsGiven) scenario.buttons.clear();
+        parser.buttonsGiven = true;
+        ScenarioButton button;
+        ok = parseInt(p, end, button.column) && parseInt(p, end, button.row) && button.column >= 0 && button.column <= 1;
+        std::string_view action = nextToken(p, end);
+        if (action == "open") button.action = -1;
+        else if (action == "close") button.action = -2;
+        else if (action == "stop") button.action = -3;
+        else if (action == "fan") button.action = -4;
+        else {
+            auto result = std::from_chars(action.data(), action.data() + action.size(), button.action);
+            ok = ok && result.ec == std::errc() && button.action >= 0 && button.action < NUM_FLOORS;
+        }
+        std::string_view texture = nextToken(p, end);
+        ok = ok && !texture.empty();
+        button.texture = std::string(texture);
+        if (ok) scenario.buttons.push_back(button);
+    } else if (key == "trips") {
+        int count = 0;
+        skipSpaces(p, end);
+        if (p < end) ok = parseInt(p, end, count) && count >= 0;
+        scenario.trips.clear();
+        scenario.trips.reserve(count);
+        parser.inTrips = true;
+    } else {
+        return fail(parser, "unknown setting");
+    }
+
+    if (!ok) return fail(parser, "bad value");
+    skipSpaces(p, end);
+    if (p < end) return fail(parser, "unexpected text after the value");
+    return true;
+}
+
+static bool parseLine(ScenarioParser& parser, const char* p, const char* end)
+{
+    parser.line++;
+    const char* comment = (const char*)memchr(p, '#', end - p);
+    if (comment) end = comment;
+    while (end > p && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) end--;
+    skipSpaces(p, end);
+    if (p == end) return true;
+    return parser.inTrips ? parseTrip(parser, p, end) : parseSetting(parser, p, end);
+}
+
+bool loadScenario(const char* path, Scenario& scenario)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        std::cout << "Could not open " << path << std::endl;
+        return false;
+    }
+
+    ScenarioParser parser = {&scenario, path, 0, false, false, false, true};
+    scenario.bytesRead = 0;
+    std::vector<char> buffer(SCENARIO_CHUNK_BYTES);
+    size_t carried = 0;     // Unfinished last line of the previous chunk
+    bool ok = true;
+
+    while (ok) {
+        size_t got = fread(buffer.data() + carried, 1, buffer.size() - carried, file);
+        scenario.bytesRead += got;
+        const char* p = buffer.data();
+        const char* end = p + carried + got;
+
+        if (got == 0) {
+            if (carried > 0) ok = parseLine(parser, p, end);
+            break;
+        }
+        for (const char* eol; ok && (eol = (const char*)memchr(p, '\n', end - p)) != nullptr; p = eol + 1) {
+            ok = parseLine(parser, p, eol);
+        }
+
+        carried = end - p;
+        if (ok && carried == buffer.size()) {
+            parser.line++;
+            ok = fail(parser, "line too long");
+        }
+        memmove(buffer.data(), p, carried);
+    }
+    fclose(file);
+    if (!ok) return false;
+
+    // Floors may be set after the zones and traffic that refer to them
+    SimConfig& config = scenario.config;
+    bool inside = config.traffic.lobbyFloor < config.numFloors;
+    for (const Zone& zone : config.zones) {
+        inside = inside && zone.lowestFloor < config.numFloors && zone.highestFloor < config.numFloors &&
+                 zone.lobbyFloor < config.numFloors;
+    }
+    if (!inside) {
+        std::cout << path << ": zone or lobby floor outside the building" << std::endl;
+        return false;
+    }
+    if (!config.zones.empty()) {
+        config.numCars = 0;
+        for (const Zone& zone : config.zones) config.numCars += zone.numCars;
+    }
+    if (!parser.sorted) {
+        std::stable_sort(scenario.trips.begin(), scenario.trips.end(),
+                         [](const ScheduledTrip& a, const ScheduledTrip& b) { return a.time < b.time; });
+    }
+    return true;
+}
+
+SimStats runScenario(Scenario& scenario, float deltaTime)
+{
+    Simulation sim;
+    initSimulation(sim, scenario.config);
+    sim.schedule.swap(scenario.trips);
+    sim.passengers.reserve(sim.schedule.size());
+    while (sim.time < scenario.duration) {
+        stepSimulation(sim, deltaTime);
+    }
+    sim.schedule.swap(scenario.trips);
+    return sim.stats;
+}
@@ -0,0 +1,216 @@
+#include "../Header/Shader.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Linear probing past taken slots. Two names with the same full hash cannot be
+// told apart by their handles, so the program would set the wrong uniform -
+// that stops here instead, and a uniform has to be renamed.
+static void insertUniform(ShaderProgram& program, const std::string& name, int location)
+{
+    UniformHandle hash = uniformHash(name.c_str());
+    unsigned int i = hash & program.mask;
+    while (program.slots[i].hash != 0) {
+        if (program.slots[i].hash == hash) {
+            std::cout << "Uniform " << name << " has the same hash as another uniform of program " << program.id << std::endl;
+            std::abort();
+        }
+        i = (i + 1) & program.mask;
+    }
+    program.slots[i] = {hash, location};
+}
+
+ShaderProgram createShaderProgram(const char* vsSource, const char* fsSource)
+{
+    ShaderProgram program;
+    program.id = createShader(vsSource, fsSource);
+
+    int count = 0, maxLength = 0;
+    glGetProgramiv(program.id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program.id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    // At most half full, so probes stay short
+    unsigned int size = 8;
+    while (size < 2u * (unsigned int)count) size *= 2;
+    program.mask = size - 1;
+    program.slots.assign(size, {0, -1});
+
+    std::vector<char> buffer(maxLength + 1);
+    for (int i = 0; i < count; i++) {
+        int length = 0, arraySize = 0;
+        GLenum type;
+        glGetActiveUniform(program.id, i, (GLsizei)buffer.size(), &length, &arraySize, &type, buffer.data());
+        std::string name(buffer.data(), length);
+
+        // Uniform block members have no location of their own
+        int location = glGetUniformLocation(program.id, name.c_str());
+        if (location < 0) continue;
+
+        // Arrays are reported as "name[0]" - element 0's location uploads the whole array
+        size_t bracket = name.find('[');
+        if (bracket != std::string::npos) name.resize(bracket);
+        insertUniform(program, name, location);
+    }
+    return program;
+}
+
+void deleteShaderProgram(ShaderProgram& program)
+{
+    glDeleteProgram(program.id);
+    program.id = 0;
+    program.slots.clear();
+}
+
+int uniformLocation(const ShaderProgram& program, UniformHandle uniform)
+{
+    unsigned int i = uniform & program.mask;
+    while (program.slots[i].hash != 0) {
+        if (program.slots[i].hash == uniform) return program.slots[i].location;
+        i = (i + 1) & program.mask;
+    }
+    return -1;
+}
+
+void setShaderMat4(const ShaderProgram& program, UniformHandle uniform, const Mat4& mat)
+{
+    glUniformMatrix4fv(uniformLocation(program, uniform), 1, GL_FALSE, mat.m);
+}
+
+void setShaderVec3(const ShaderProgram& program, UniformHandle uniform, const Vec3& vec)
+{
+    glUniform3f(uniformLocation(program, uniform), vec.x, vec.y, vec.z);
+}
+
+void setShaderVec4(const ShaderProgram& program, UniformHandle uniform, float x, float y, float z, float w)
+{
+    glUniform4f(uniformLocation(program, uniform), x, y, z, w);
+}
+
+void setShaderFloat(const ShaderProgram& program, UniformHandle uniform, float value)
+{
+    glUniform1f(uniformLocation(program, uniform), value);
+}
+
+void setShaderInt(const ShaderProgram& program, UniformHandle uniform, int value)
+{
+    glUniform1i(uniformLocation(program, uniform), value);
+}
+
+void createFrameUniforms(FrameUniforms& frame)
+{
+    int alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    auto alignUp = [alignment](int size) { return (size + alignment - 1) / alignment * alignment; };
+
+    frame.lightOffset = alignUp((int)sizeof(FrameBlock));
+    frame.lightStride = alignUp((int)sizeof(LightBlock));
+    frame.lights = 0;
+    frame.staging.assign(frame.lightOffset + MAX_LIGHT_PASSES * frame.lightStride, 0);
+
+    glGenBuffers(1, &frame.buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, frame.buffer);
+    glBufferData(GL_UNIFORM_BUFFER, frame.staging.size(), NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, frame.buffer, 0, sizeof(FrameBlock));
+}
+
+void deleteFrameUniforms(FrameUniforms& frame)
+{
+    glDeleteBuffers(1, &frame.buffer);
+    frame.buffer = 0;
+    frame.staging.clear();
+}
+
+void bindFrameBlocks(const ShaderProgram& program)
+{
+    unsigned int frameIndex = glGetUniformBlockIndex(program.id, "Frame");
+    if (frameIndex != GL_INVALID_INDEX) glUniformBlockBinding(program.id, frameIndex, FRAME_BLOCK_BINDING);
+    unsigned int lightIndex = glGetUniformBlockIndex(program.id, "Light");
+    if (lightIndex != GL_INVALID_INDEX) glUniformBlockBinding(program.id, lightIndex, LIGHT_BLOCK_BINDING);
+    unsigned int buttonIndex = glGetUniformBlockIndex(program.id, "ButtonLights");
+    if (buttonIndex != GL_INVALID_INDEX) glUniformBlockBinding(program.id, buttonIndex, BUTTON_LIGHT_BLOCK_BINDING);
+}
+
+void setFrameCamera(FrameUniforms& frame, const Mat4& view, const Mat4& projection, const Vec3& viewPos)
+{
+    FrameBlock block = {};
+    memcpy(block.view, view.m, sizeof(block.view));
+    memcpy(block.projection, projection.m, sizeof(block.projection));
+    block.viewPos[0] = viewPos.x;
+    block.viewPos[1] = viewPos.y;
+    block.viewPos[2] = viewPos.z;
+    memcpy(frame.staging.data(), &block, sizeof(block));
+    frame.lights = 0;
+}
+
+void setFramePanelOrigin(FrameUniforms& frame, const Vec3& origin)
+{
+    FrameBlock* block = (FrameBlock*)frame.staging.data();
+    block->panelOrigin[0] = origin.x;
+    block->panelOrigin[1] = origin.y;
+    block->panelOrigin[2] = origin.z;
+}
+
+int addFrameLight(FrameUniforms& frame, const Vec3& lightPos, const Vec3& lightColor, float constant, float linear, float quadratic)
+{
+    if (frame.lights == MAX_LIGHT_PASSES) {
+        std::cout << "More than " << MAX_LIGHT_PASSES << " light passes in one frame" << std::endl;
+        return frame.lights - 1;
+    }
+    LightBlock block = {};
+    block.lightPos[0] = lightPos.x;
+    block.lightPos[1] = lightPos.y;
+    block.lightPos[2] = lightPos.z;
+    block.lightColor[0] = lightColor.x;
+    block.lightColor[1] = lightColor.y;
+    block.lightColor[2] = lightColor.z;
+    block.constant = constant;
+    block.linear = linear;
+    block.quadratic = quadratic;
+    memcpy(frame.staging.data() + frame.lightOffset + frame.lights * frame.lightStride, &block, sizeof(block));
+    return frame.lights++;
+}
+
+void uploadFrameUniforms(const FrameUniforms& frame)
+{
+    // Only the passes in use - respecifying the store lets the driver orphan last frame's copy
+    size_t used = frame.lightOffset + frame.lights * frame.lightStride;
+    glBindBuffer(GL_UNIFORM_BUFFER, frame.buffer);
+    glBufferData(GL_UNIFORM_BUFFER, frame.staging.size(), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, used, frame.staging.data());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void useFrameLight(const FrameUniforms& frame, int light)
+{
+    glBindBufferRange(GL_UNIFORM_BUFFER, LIGHT_BLOCK_BINDING, frame.buffer,
+                      frame.lightOffset + light * frame.lightStride, sizeof(LightBlock));
+}
+
+void createButtonLights(ButtonLightBuffer& lights)
+{
+    lights.uploaded = {};
+    glGenBuffers(1, &lights.buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, lights.buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(ButtonLightBlock), &lights.uploaded, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, BUTTON_LIGHT_BLOCK_BINDING, lights.buffer);
+}
+
+void deleteButtonLights(ButtonLightBuffer& lights)
+{
+    glDeleteBuffers(1, &lights.buffer);
+    lights.buffer = 0;
+}
+
+bool updateButtonLights(ButtonLightBuffer& lights, const ButtonLightBlock& block)
+{
+    if (memcmp(&lights.uploaded, &block, sizeof(block)) == 0) return false;
+    lights.uploaded = block;
+    glBindBuffer(GL_UNIFORM_BUFFER, lights.buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    return true;
+}
@@ -0,0 +1,990 @@
+#include "../Header/Simulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+SimConfig defaultSimConfig()
+{
+    SimConfig config;
+    config.numFloors = NUM_FLOORS;
+    config.numCars = 2;
+    config.carDecks = 1;
+    config.carsPerShaft = 1;
+    config.carSpeed = 3.0f;
+    config.capacityPersons = ELEVATOR_CAPACITY_PERSONS;
+    config.capacityKg = ELEVATOR_CAPACITY_KG;
+    config.doorOpenTime = DOOR_OPEN_TIME;
+    config.doorExtendedTime = DOOR_EXTENDED_TIME;
+    config.traffic = {12.0f, 1, 0.8f, 0.5f};     // Morning up-peak out of the ground floor (PR)
+    config.parking = ParkingStrategy::PredictedDemand;
+    config.adaptiveDispatch = true;
+    for (int mode = 0; mode < TRAFFIC_MODE_COUNT; mode++) config.dispatchByMode[mode] = dispatchParamsFor((TrafficMode)mode);
+    config.assignment = AssignmentMethod::Greedy;
+    config.energySaving = false;
+    config.startTimeOfDay = 8.0f * 3600.0f;
+    config.seed = 12345;
+    return config;
+}
+
+SimConfig zonedTowerConfig(int numFloors)
+{
+    SimConfig config = defaultSimConfig();
+    config.numFloors = numFloors;
+    config.carSpeed = 15.0f;            // 2.5 floors per second for the long express runs
+    config.capacityPersons = 20;
+    config.capacityKg = 1600.0f;
+    config.traffic.arrivalsPerMinute = 60.0f;
+
+    int lobby = config.traffic.lobbyFloor;
+    int lowTop = lobby + (numFloors - lobby) / 3;
+    int midTop = lobby + 2 * (numFloors - lobby) / 3;
+    int skyLobby = midTop + 1;
+    config.zones = {
+        {0, lowTop, lobby, 4},                      // Low-rise, also serves the basement
+        {lowTop + 1, midTop, lobby, 4},             // Mid-rise, express past the low-rise floors
+        {skyLobby, skyLobby, lobby, 3},             // Shuttle to the sky lobby
+        {skyLobby + 1, numFloors - 1, skyLobby, 4}  // High-rise, loads at the sky lobby
+    };
+    config.numCars = 0;
+    for (const Zone& zone : config.zones) config.numCars += zone.numCars;
+    return config;
+}
+
+bool zoneServesFloor(const Zone& zone, int floor)
+{
+    return floor == zone.lobbyFloor || (floor >= zone.lowestFloor && floor <= zone.highestFloor);
+}
+
+DispatchParams dispatchParamsFor(TrafficMode mode)
+{
+    switch (mode) {
+    case TrafficMode::UpPeak: return {1.0f, 1.0f, 0.5f, true};
+    case TrafficMode::DownPeak: return {1.0f, 0.7f, 2.0f, false};
+    case TrafficMode::TwoWay: return {1.0f, 1.0f, 1.0f, false};
+    case TrafficMode::Interfloor: return {1.0f, 1.3f, 0.5f, false};
+    }
+    return {1.0f, 1.0f, 1.0f, false};
+}
+
+void initDemandHistory(DemandHistory& history, int numFloors)
+{
+    history.numFloors = numFloors;
+    history.calls.assign(DEMAND_BUCKETS_PER_DAY * numFloors, 0.0f);
+}
+
+static int demandBucket(float timeOfDay)
+{
+    int bucket = (int)(timeOfDay / DEMAND_BUCKET_SECONDS) % DEMAND_BUCKETS_PER_DAY;
+    return bucket < 0 ? bucket + DEMAND_BUCKETS_PER_DAY : bucket;
+}
+
+void recordDemand(DemandHistory& history, float timeOfDay, int floor)
+{
+    history.calls[demandBucket(timeOfDay) * history.numFloors + floor] += 1.0f;
+}
+
+std::vector<float> predictDemand(const DemandHistory& history, float timeOfDay, float horizon)
+{
+    // The buckets covering the horizon come from earlier days; the bucket just
+    // before "now" stands in for them until the first day has been seen
+    std::vector<float> predicted(history.numFloors, 0.0f);
+    int first = demandBucket(timeOfDay) - 1;
+    int last = demandBucket(timeOfDay) + (int)std::ceil(horizon / DEMAND_BUCKET_SECONDS);
+    for (int b = first; b <= last; b++) {
+        int bucket = (b + DEMAND_BUCKETS_PER_DAY) % DEMAND_BUCKETS_PER_DAY;
+        for (int floor = 0; floor < history.numFloors; floor++) {
+            predicted[floor] += history.calls[bucket * history.numFloors + floor];
+        }
+    }
+    return predicted;
+}
+
+static float timeOfDay(const Simulation& sim)
+{
+    return std::fmod(sim.config.startTimeOfDay + sim.time, 86400.0);
+}
+
+static float sampleInterarrival(Simulation& sim)
+{
+    float rate = sim.config.traffic.arrivalsPerMinute / 60.0f;
+    if (rate <= 0.0f) return 1e30f;
+    std::exponential_distribution<float> dist(rate);
+    return dist(sim.rng);
+}
+
+// Fewest-rides route between every pair of floors (breadth-first over the zones)
+static void buildRoutes(Simulation& sim)
+{
+    int floors = sim.config.numFloors;
+    sim.routeFloor.assign(floors * floors, -1);
+    sim.routeZone.assign(floors * floors, -1);
+
+    std::vector<int> rides(floors), firstFloor(floors), firstZone(floors);
+    std::vector<int> frontier, next;
+    for (int origin = 0; origin < floors; origin++) {
+        std::fill(rides.begin(), rides.end(), -1);
+        rides[origin] = 0;
+        frontier.assign(1, origin);
+
+        while (!frontier.empty()) {
+            next.clear();
+            for (int from : frontier) {
+                for (int z = 0; z < (int)sim.zones.size(); z++) {
+                    const Zone& zone = sim.zones[z];
+                    if (!zoneServesFloor(zone, from)) continue;
+
+                    auto reach = [&](int to) {
+                        if (to < 0 || to >= floors || rides[to] >= 0) return;
+                        rides[to] = rides[from] + 1;
+                        firstFloor[to] = from == origin ? to : firstFloor[from];
+                        firstZone[to] = from == origin ? z : firstZone[from];
+                        next.push_back(to);
+                    };
+                    reach(zone.lobbyFloor);
+                    for (int to = zone.lowestFloor; to <= zone.highestFloor; to++) reach(to);
+                }
+            }
+            frontier.swap(next);
+        }
+
+        for (int destination = 0; destination < floors; destination++) {
+            if (rides[destination] <= 0) continue;
+            sim.routeFloor[origin * floors + destination] = firstFloor[destination];
+            sim.routeZone[origin * floors + destination] = firstZone[destination];
+        }
+    }
+}
+
+void initSimulation(Simulation& sim, const SimConfig& config)
+{
+    sim.config = config;
+    int lobby = config.traffic.lobbyFloor;
+
+    sim.zones = config.zones;
+    if (sim.zones.empty()) {
+        sim.zones.push_back({0, config.numFloors - 1, lobby, config.numCars});
+    }
+
+    sim.cars.clear();
+    sim.carZone.clear();
+    sim.zoneFloors.assign(sim.zones.size(), std::vector<int>());
+    sim.shafts.clear();
+    sim.carShaft.clear();
+    sim.carShaftSlot.clear();
+    sim.carLowestFloor.clear();
+    sim.carHighestFloor.clear();
+    for (int z = 0; z < (int)sim.zones.size(); z++) {
+        std::vector<int>& floors = sim.zoneFloors[z];
+        for (int floor = 0; floor < config.numFloors; floor++) {
+            if (zoneServesFloor(sim.zones[z], floor)) floors.push_back(floor);
+        }
+        int lobbyIndex = (int)(std::find(floors.begin(), floors.end(), sim.zones[z].lobbyFloor) - floors.begin());
+
+        // Stacked cars split the zone's floors: the car in slot k of an n-car shaft
+        // cannot reach the k lowest or the n - 1 - k highest floors
+        int perShaft = config.carDecks > 1 ? 1 : std::max(1, config.carsPerShaft);
+        if ((int)floors.size() <= perShaft) perShaft = 1;
+
+        int zoneCars = sim.zones[z].numCars;
+        int startIndex = 0;     // Cars start as close to the lobby as the car below allows
+        for (int i = 0; i < zoneCars; i++) {
+            int slot = i % perShaft;
+            int shaftSize = std::min(perShaft, zoneCars - i + slot);
+            if (slot == 0) sim.shafts.push_back(std::vector<int>());
+            sim.shafts.back().push_back((int)sim.cars.size());
+
+            int lowIndex = slot;
+            int highIndex = (int)floors.size() - shaftSize + slot;
+            int belowIndex = startIndex;
+            startIndex = std::min(std::max(lobbyIndex, lowIndex), highIndex);
+            if (slot > 0) startIndex = std::max(startIndex, belowIndex + 1);
+
+            Elevator car = {0.0f, 0, 0, false, false, 0.0f, config.carSpeed, false, {}};
+            car.decks = config.carDecks;
+            car.currentFloor = car.targetFloor = stopFloorFor(car, floors[startIndex]);
+            car.y = getFloorYPosition(car.currentFloor);
+            car.capacityPersons = config.capacityPersons;
+            car.capacityKg = config.capacityKg;
+            car.doorOpenTime = config.doorOpenTime;
+            car.doorExtendedTime = config.doorExtendedTime;
+            sim.cars.push_back(car);
+            sim.carZone.push_back(z);
+            sim.carShaft.push_back((int)sim.shafts.size() - 1);
+            sim.carShaftSlot.push_back(slot);
+            sim.carLowestFloor.push_back(floors[lowIndex]);
+            sim.carHighestFloor.push_back(floors[highIndex]);
+        }
+    }
+    int numCars = (int)sim.cars.size();
+    int numCalls = (int)sim.zones.size() * config.numFloors;
+    sim.carDoorsWereOpen.assign(numCars, false);
+    sim.carBlockedSince.assign(numCars, -1.0f);
+
+    sim.passengers.clear();
+    sim.waiting.assign(numCalls, std::vector<int>());
+    sim.riding.assign(numCars, std::vector<int>());
+    sim.hallCallCar.assign(numCalls, -1);
+    sim.hallCallBypassed.assign(numCalls, false);
+    sim.carParking.assign(numCars, false);
+    buildRoutes(sim);
+    initDemandHistory(sim.demand, config.numFloors);
+    sim.nextParkingReview = 0.0f;
+    initTrafficEstimator(sim.traffic, config.traffic.lobbyFloor, TRAFFIC_TIME_CONSTANT);
+    sim.trafficMode = TrafficMode::TwoWay;
+    sim.lastModeSwitch = 0.0f;
+    sim.dispatch = config.dispatchByMode[(int)sim.trafficMode];
+
+    sim.plans.assign(sim.zones.size(), AssignmentSolver());
+    sim.planCalls.assign(sim.zones.size(), std::vector<int>());
+    sim.planCars.assign(sim.zones.size(), std::vector<int>());
+    for (int i = 0; i < numCars; i++) sim.planCars[sim.carZone[i]].push_back(i);
+    sim.nextReplan = 0.0f;
+
+    sim.eta.resize(numCars);
+    for (int i = 0; i < numCars; i++) initEtaTable(sim.eta[i], sim.cars[i], config.numFloors, 0.0f);
+
+    sim.schedule.clear();
+    sim.nextScheduled = 0;
+    sim.recordEvents = false;
+    sim.boardedEvents.clear();
+    sim.deliveredEvents.clear();
+
+    sim.time = 0.0;
+    sim.rng.seed(config.seed);
+    sim.stats = SimStats();
+    sim.nextArrivalTime = sampleInterarrival(sim);
+}
+
+// Stop that puts the rider's cabin at the end of their ride. Double-deck cars
+// stop with either cabin at any floor; at the ends of the shaft the cabin may
+// stop a floor short.
+static int rideStopFor(const Simulation& sim, const Elevator& car, const Passenger& p)
+{
+    return std::min(std::max(p.legDestination - p.deck, 0), stopFloorFor(car, sim.config.numFloors - 1));
+}
+
+// Double-deck passengers walk between the two floors of the lobby stop - the
+// two-level lobby - and wherever the end of the shaft leaves no stop to line
+// their cabin up with the other floor
+static bool walksWithinStop(const Simulation& sim, int zone, int floor, int destination)
+{
+    if (sim.config.carDecks < 2 || floor / 2 != destination / 2) return false;
+    if (floor / 2 == sim.zones[zone].lobbyFloor / 2) return true;
+    int stop = destination - floor % 2;
+    return stop < 0 || stop > (sim.config.numFloors - 1) / 2 * 2;
+}
+
+static void deliverPassenger(Simulation& sim, int id)
+{
+    sim.passengers[id].delivered = true;
+    sim.stats.delivered++;
+    if (sim.recordEvents) sim.deliveredEvents.push_back(id);
+}
+
+// A stacked car takes passengers for floors beyond its reach as far as it can go;
+// they change to the next car of the shaft there
+static int rideEndFor(const Simulation& sim, int carIndex, int floor)
+{
+    return std::min(std::max(floor, sim.carLowestFloor[carIndex]), sim.carHighestFloor[carIndex]);
+}
+
+static bool carReaches(const Simulation& sim, int carIndex, int floor)
+{
+    return floor >= sim.carLowestFloor[carIndex] && floor <= sim.carHighestFloor[carIndex];
+}
+
+// Part of the shaft a car occupies until its current move ends
+static void reservedSpan(const Elevator& car, float& low, float& high)
+{
+    float end = car.moving ? getFloorYPosition(car.targetFloor) : car.y;
+    low = std::min(car.y, end);
+    high = std::max(car.y, end);
+}
+
+// Neighbour in the shaft that leaves too little room for a move to "floor", -1 if the move is clear
+static int shaftConflict(const Simulation& sim, int carIndex, int floor)
+{
+    const std::vector<int>& shaft = sim.shafts[sim.carShaft[carIndex]];
+    int slot = sim.carShaftSlot[carIndex];
+    const Elevator& car = sim.cars[carIndex];
+    float end = getFloorYPosition(floor);
+    float low = std::min(car.y, end);
+    float high = std::max(car.y, end);
+    float gap = SHAFT_MIN_SEPARATION - 0.01f;
+    float otherLow, otherHigh;
+
+    if (slot + 1 < (int)shaft.size()) {
+        reservedSpan(sim.cars[shaft[slot + 1]], otherLow, otherHigh);
+        if (otherLow - high < gap) return shaft[slot + 1];
+    }
+    if (slot > 0) {
+        reservedSpan(sim.cars[shaft[slot - 1]], otherLow, otherHigh);
+        if (low - otherHigh < gap) return shaft[slot - 1];
+    }
+    return -1;
+}
+
+// Sends a standing car just far enough away for "forCar" to reach "floor"
+static void stepAside(Simulation& sim, int carIndex, int forCar, int floor)
+{
+    Elevator& car = sim.cars[carIndex];
+    const std::vector<int>& floors = sim.zoneFloors[sim.carZone[carIndex]];
+    bool up = sim.carShaftSlot[carIndex] > sim.carShaftSlot[forCar];
+    float clearY = getFloorYPosition(floor) + (up ? SHAFT_MIN_SEPARATION : -SHAFT_MIN_SEPARATION);
+
+    int target = -1;
+    for (int j = 0; j < (int)floors.size(); j++) {
+        int f = up ? floors[j] : floors[floors.size() - 1 - j];
+        bool clear = up ? getFloorYPosition(f) >= clearY - 0.01f : getFloorYPosition(f) <= clearY + 0.01f;
+        if (clear && carReaches(sim, carIndex, f)) {
+            target = f;
+            break;
+        }
+    }
+    if (target < 0 || target == car.currentFloor) return;
+    if (!car.queuedFloors.empty() && car.queuedFloors[0] == target) return;
+
+    std::vector<int>& queue = car.queuedFloors;
+    queue.erase(std::remove(queue.begin(), queue.end(), target), queue.end());
+    queue.insert(queue.begin(), target);
+    sim.carParking[carIndex] = false;
+    sim.stats.shaftYields++;
+}
+
+// Puts the first stop the shaft has room for at the front of the car's queue.
+// Returns false if the car has to stay where it is this step; the car in its
+// way then steps aside if it is idle, is itself held but lost the hold to this
+// car, or has kept this car waiting longer than SHAFT_YIELD_AFTER.
+static bool scheduleShaftMove(Simulation& sim, int carIndex, float deltaTime)
+{
+    Elevator& car = sim.cars[carIndex];
+    std::vector<int>& queue = car.queuedFloors;
+    if (sim.shafts[sim.carShaft[carIndex]].size() < 2 || car.moving || queue.empty()) {
+        sim.carBlockedSince[carIndex] = -1.0f;
+        return true;
+    }
+
+    for (size_t j = 0; j < queue.size(); j++) {
+        if (shaftConflict(sim, carIndex, queue[j]) < 0) {
+            std::rotate(queue.begin(), queue.begin() + j, queue.begin() + j + 1);
+            sim.carBlockedSince[carIndex] = -1.0f;
+            return true;
+        }
+    }
+    if (car.doorsOpen) return false;    // Still loading - only the departure waits
+
+    float& since = sim.carBlockedSince[carIndex];
+    if (since < 0.0f) since = sim.time;
+    sim.stats.shaftBlockedTime += deltaTime;
+
+    int blocker = shaftConflict(sim, carIndex, queue[0]);
+    const Elevator& other = sim.cars[blocker];
+    if (other.moving || other.doorsOpen) return false;
+
+    float otherSince = sim.carBlockedSince[blocker];
+    bool otherLost = otherSince >= 0.0f && (otherSince > since || (otherSince == since && blocker > carIndex));
+    if (other.queuedFloors.empty() || otherLost || sim.time - since > SHAFT_YIELD_AFTER) {
+        stepAside(sim, blocker, carIndex, queue[0]);
+    }
+    return false;
+}
+
+// Tries to put a passenger waiting on "floor" into a car standing there. In a
+// double-deck car they take the cabin at their landing; only in the two-level
+// lobby do they change level for the cabin that stops at their destination.
+static bool boardPassenger(Simulation& sim, int carIndex, int id, int floor)
+{
+    Elevator& car = sim.cars[carIndex];
+    Passenger& p = sim.passengers[id];
+    Passenger ride = p;
+    ride.legDestination = rideEndFor(sim, carIndex, p.legDestination);
+    ride.deck = floor - car.currentFloor;
+    if (car.decks > 1 && car.currentFloor == stopFloorFor(car, sim.zones[sim.carZone[carIndex]].lobbyFloor)) {
+        ride.deck = deckFor(car, ride.legDestination);
+    }
+    int stop = rideStopFor(sim, car, ride);
+    if (stop == car.currentFloor) return false;     // Out of this stacked car's reach
+
+    if (!boardElevator(car, p.weightKg, ride.deck)) {
+        if (!p.refused) sim.stats.refusedBoardings++;
+        p.refused = true;
+        return false;
+    }
+
+    p.car = carIndex;
+    p.deck = ride.deck;
+    p.legDestination = ride.legDestination;
+    p.boardTime = sim.time;
+    sim.riding[carIndex].push_back(id);
+
+    float wait = p.boardTime - p.callTime;
+    if (sim.recordEvents) sim.boardedEvents.push_back(id);
+    sim.stats.boarded++;
+    sim.stats.totalWaitTime += wait;
+    sim.stats.maxWaitTime = std::max(sim.stats.maxWaitTime, wait);
+
+    addFloorToQueue(car, stop);
+    return true;
+}
+
+// Starts the next ride of a trip from "floor": picks the zone from the route
+// table and either boards a car already standing there or joins the landing queue
+static void beginRide(Simulation& sim, int id, int floor)
+{
+    int floors = sim.config.numFloors;
+    Passenger& p = sim.passengers[id];
+    p.legDestination = sim.routeFloor[floor * floors + p.destination];
+    p.legZone = sim.routeZone[floor * floors + p.destination];
+    p.callTime = sim.time;
+    p.boardTime = -1.0f;
+    p.car = -1;
+    p.deck = 0;
+
+    if (walksWithinStop(sim, p.legZone, floor, p.legDestination)) {
+        sim.stats.stairTrips++;
+        if (p.legDestination == p.destination) {
+            deliverPassenger(sim, id);
+        } else {
+            beginRide(sim, id, p.legDestination);
+        }
+        return;
+    }
+    recordDemand(sim.demand, timeOfDay(sim), floor);
+
+    for (int i = 0; i < (int)sim.cars.size(); i++) {
+        const Elevator& car = sim.cars[i];
+        if (sim.carZone[i] == p.legZone && car.doorsOpen && isAtStopFor(car, floor)) {
+            if (boardPassenger(sim, i, id, floor)) return;
+            break;
+        }
+    }
+    sim.waiting[p.legZone * floors + floor].push_back(id);
+}
+
+// Takes a landing call back from its car, dropping the stop unless a rider or
+// another call of the car still needs it
+static void releaseHallCall(Simulation& sim, int call, int floor)
+{
+    int carIndex = sim.hallCallCar[call];
+    if (carIndex < 0) return;
+    sim.hallCallCar[call] = -1;
+
+    Elevator& car = sim.cars[carIndex];
+    int stop = stopFloorFor(car, floor);
+    for (int id : sim.riding[carIndex]) {
+        if (rideStopFor(sim, car, sim.passengers[id]) == stop) return;
+    }
+    int zoneStart = call - floor;
+    for (int other = stop; other < stop + car.decks && other < sim.config.numFloors; other++) {
+        if (other != floor && sim.hallCallCar[zoneStart + other] == carIndex) return;
+    }
+    std::vector<int>& queue = car.queuedFloors;
+    queue.erase(std::remove(queue.begin(), queue.end(), stop), queue.end());
+}
+
+// Doors just opened - let riders out, then take as many waiting passengers as fit.
+// Every cabin of the car serves its own floor at the stop.
+static void serveFloor(Simulation& sim, int carIndex)
+{
+    Elevator& car = sim.cars[carIndex];
+    int stop = car.currentFloor;
+    sim.carParking[carIndex] = false;
+
+    std::vector<int>& riders = sim.riding[carIndex];
+    for (size_t i = 0; i < riders.size(); ) {
+        int id = riders[i];
+        Passenger& p = sim.passengers[id];
+        if (rideStopFor(sim, car, p) != stop) {
+            i++;
+            continue;
+        }
+
+        int floor = p.legDestination;
+        alightElevator(car, p.weightKg, p.deck);
+        sim.stats.totalRideTime += sim.time - p.boardTime;
+        riders.erase(riders.begin() + i);
+        if (stop + p.deck != floor) sim.stats.stairTrips++;    // Cabin stopped a floor short at the end of the shaft
+
+        if (floor == p.destination) {
+            deliverPassenger(sim, id);
+        } else {
+            sim.stats.transfers++;
+            beginRide(sim, id, floor);
+        }
+    }
+
+    for (int floor = stop; floor < stop + car.decks && floor < sim.config.numFloors; floor++) {
+        int call = sim.carZone[carIndex] * sim.config.numFloors + floor;
+        if (sim.hallCallCar[call] == carIndex) {
+            // A double-deck car standing a floor off the call's stop drops that stop too
+            if (stopFloorFor(car, floor) != stop) releaseHallCall(sim, call, floor);
+            else sim.hallCallCar[call] = -1;
+        }
+
+        std::vector<int>& queue = sim.waiting[call];
+        for (size_t i = 0; i < queue.size(); ) {
+            if (boardPassenger(sim, carIndex, queue[i], floor)) queue.erase(queue.begin() + i);
+            else i++;
+        }
+    }
+}
+
+static void syncCarEta(Simulation& sim, int carIndex)
+{
+    EtaTable& table = sim.eta[carIndex];
+    long long computed = table.entriesComputed;
+    syncEtaTable(table, sim.cars[carIndex], sim.time);
+    sim.stats.etaEntriesComputed += table.entriesComputed - computed;
+}
+
+// Hall call cost = travel * travelWeight + door time ahead * stopWeight + load * loadWeight * door time,
+// with travel and door time read from the car's predicted arrival along its route
+static float etaCost(Simulation& sim, int carIndex, int floor)
+{
+    syncCarEta(sim, carIndex);
+    const Elevator& car = sim.cars[carIndex];
+    Eta eta = estimateArrival(sim.eta[carIndex], car, stopFloorFor(car, floor), sim.time);
+    sim.stats.etaQueries++;
+    return eta.travel * sim.dispatch.travelWeight + eta.dwell * sim.dispatch.stopWeight +
+           getLoadFactor(car) * sim.dispatch.loadWeight * car.doorOpenTime;
+}
+
+// A stacked car answers a landing only if it can take someone waiting there
+static bool canServeLanding(const Simulation& sim, int carIndex, int call, int floor)
+{
+    if (!carReaches(sim, carIndex, floor)) return false;
+    for (int id : sim.waiting[call]) {
+        if (rideEndFor(sim, carIndex, sim.passengers[id].legDestination) != floor) return true;
+    }
+    return false;
+}
+
+// Hands a landing call to a car
+static void assignHallCall(Simulation& sim, int call, int floor, int carIndex)
+{
+    sim.hallCallCar[call] = carIndex;
+    if (sim.hallCallBypassed[call]) {
+        sim.stats.bypassedHallCalls++;
+        sim.hallCallBypassed[call] = false;
+    }
+
+    // A parking trip gives way to the call
+    Elevator& car = sim.cars[carIndex];
+    int stop = stopFloorFor(car, floor);
+    if (sim.carParking[carIndex]) {
+        sim.carParking[carIndex] = false;
+        car.queuedFloors.clear();
+        if (car.moving && shaftConflict(sim, carIndex, stop) < 0) {
+            startRun(car, stop);
+            return;
+        }
+    }
+    addHallCall(car, stop);
+}
+
+// Drive energy the call adds to the car: one more stop on its route, or a run on from the end of it.
+// The car's ETA table must be synced.
+static float callEnergy(const Simulation& sim, int carIndex, int floor)
+{
+    const Elevator& car = sim.cars[carIndex];
+    const EtaTable& table = sim.eta[carIndex];
+    int stop = stopFloorFor(car, floor);
+    float stopY = getFloorYPosition(stop);
+    float fromY = table.floorStop[stop] >= 0 ? stopY : table.freeY;
+    return runEnergy(car, fromY, stopY, car.loadKg);
+}
+
+// Assigns a landing call to the cheapest car of the zone that is not too full to take it.
+// In energy-saving mode the car needing the least energy wins among those within
+// ENERGY_SAVING_SLACK of the cheapest.
+static void dispatchHallCall(Simulation& sim, int zone, int floor)
+{
+    int call = zone * sim.config.numFloors + floor;
+    int best = -1;
+    float bestCost = 1e30f;
+    std::vector<float> costs(sim.cars.size(), -1.0f);
+    for (int i = 0; i < (int)sim.cars.size(); i++) {
+        if (sim.carZone[i] != zone || !canServeLanding(sim, i, call, floor)) continue;
+        if (isBypassingHallCalls(sim.cars[i])) {
+            sim.hallCallBypassed[call] = true;
+            continue;
+        }
+        costs[i] = etaCost(sim, i, floor);
+        if (costs[i] < bestCost) {
+            bestCost = costs[i];
+            best = i;
+        }
+    }
+    if (best < 0) return;   // Every car is loaded - retried next step
+
+    if (sim.config.energySaving) {
+        float bestEnergy = callEnergy(sim, best, floor);
+        for (int i = 0; i < (int)sim.cars.size(); i++) {
+            if (costs[i] < 0.0f || costs[i] > bestCost + ENERGY_SAVING_SLACK) continue;
+            float energy = callEnergy(sim, i, floor);
+            if (energy < bestEnergy) {
+                bestEnergy = energy;
+                best = i;
+            }
+        }
+    }
+
+    assignHallCall(sim, call, floor, best);
+}
+
+// Landing with people waiting and no car of the zone standing open there
+static bool isOpenLanding(const Simulation& sim, int zone, int floor)
+{
+    if (sim.waiting[zone * sim.config.numFloors + floor].empty()) return false;
+    for (int i = 0; i < (int)sim.cars.size(); i++) {
+        const Elevator& car = sim.cars[i];
+        if (sim.carZone[i] == zone && car.doorsOpen && isAtStopFor(car, floor)) return false;
+    }
+    return true;
+}
+
+// Predicted wait of everyone on the landing, read from the car's ETA table so
+// the route it already runs - riders' stops and the calls it holds - counts;
+// the solver adds the slot cost for each call planned ahead of it
+static void fillPlanCosts(Simulation& sim, int zone, int floor, float* costs)
+{
+    int call = zone * sim.config.numFloors + floor;
+    const std::vector<int>& cars = sim.planCars[zone];
+    float waiting = (float)sim.waiting[call].size();
+    for (int k = 0; k < (int)cars.size(); k++) {
+        const Elevator& car = sim.cars[cars[k]];
+        if (!canServeLanding(sim, cars[k], call, floor)) {
+            costs[k] = ASSIGNMENT_INFEASIBLE;
+            continue;
+        }
+        if (isBypassingHallCalls(car)) {
+            if (sim.hallCallCar[call] < 0) sim.hallCallBypassed[call] = true;
+            costs[k] = ASSIGNMENT_INFEASIBLE;
+            continue;
+        }
+        costs[k] = etaCost(sim, cars[k], floor) * waiting;
+        // A car already heading for the call keeps it unless another is clearly better
+        if (sim.hallCallCar[call] == cars[k]) costs[k] *= ASSIGNMENT_KEEP_FACTOR;
+    }
+}
+
+// Moves every planned call whose car changed over to its new car
+static void applyPlan(Simulation& sim, int zone)
+{
+    const AssignmentSolver& plan = sim.plans[zone];
+    for (int c = 0; c < plan.numCalls; c++) {
+        int floor = sim.planCalls[zone][c];
+        if (!isOpenLanding(sim, zone, floor)) continue;     // Served since it was planned
+
+        int call = zone * sim.config.numFloors + floor;
+        int k = assignedCar(plan, c);
+        int carIndex = k < 0 ? -1 : sim.planCars[zone][k];
+        if (carIndex == sim.hallCallCar[call]) continue;
+
+        releaseHallCall(sim, call, floor);
+        if (carIndex >= 0) assignHallCall(sim, call, floor, carIndex);
+    }
+}
+
+// Re-optimises all open calls of the zone from fresh predicted waits
+static void replanZone(Simulation& sim, int zone)
+{
+    const std::vector<int>& cars = sim.planCars[zone];
+    std::vector<int>& calls = sim.planCalls[zone];
+    calls.clear();
+    for (int floor = 0; floor < sim.config.numFloors; floor++) {
+        if (isOpenLanding(sim, zone, floor)) calls.push_back(floor);
+    }
+    if (cars.empty()) return;
+
+    // One slot more than an even share leaves room for calls arriving before the next re-plan
+    int slots = ((int)calls.size() + (int)cars.size() - 1) / (int)cars.size() + 1;
+    std::vector<float> costs(calls.size() * cars.size());
+    for (int c = 0; c < (int)calls.size(); c++) fillPlanCosts(sim, zone, calls[c], &costs[c * cars.size()]);
+
+    AssignmentSolver& plan = sim.plans[zone];
+    resetAssignment(plan, (int)cars.size(), slots, sim.dispatch.stopWeight * sim.config.doorOpenTime);
+    solveAssignment(plan, (int)calls.size(), costs.data());
+    applyPlan(sim, zone);
+}
+
+// Batch assignment: periodic full re-plans, with new calls added to the plan as they appear
+static void planHallCalls(Simulation& sim)
+{
+    bool replan = sim.time >= sim.nextReplan;
+    if (replan) sim.nextReplan = sim.time + ASSIGNMENT_REPLAN_SECONDS;
+
+    for (int zone = 0; zone < (int)sim.zones.size(); zone++) {
+        if (replan) {
+            replanZone(sim, zone);
+            continue;
+        }
+
+        std::vector<int>& calls = sim.planCalls[zone];
+        for (int floor = 0; floor < sim.config.numFloors; floor++) {
+            int call = zone * sim.config.numFloors + floor;
+            if (sim.hallCallCar[call] >= 0 || !isOpenLanding(sim, zone, floor)) continue;
+            if (std::find(calls.begin(), calls.end(), floor) != calls.end()) continue;   // Waits for the re-plan
+
+            std::vector<float> costs(sim.planCars[zone].size());
+            fillPlanCosts(sim, zone, floor, costs.data());
+            if (!addAssignmentCall(sim.plans[zone], costs.data())) {
+                replanZone(sim, zone);
+                break;
+            }
+            calls.push_back(floor);
+            applyPlan(sim, zone);
+        }
+    }
+}
+
+static bool isIdle(const Simulation& sim, int carIndex)
+{
+    const Elevator& car = sim.cars[carIndex];
+    return !car.moving && !car.doorsOpen && car.queuedFloors.empty() && sim.riding[carIndex].empty();
+}
+
+// Sends idle cars to the busiest predicted floors of their zone that no car is covering yet,
+// after the lobby if the traffic pattern returns cars there
+static void parkIdleCars(Simulation& sim, int zone, const std::vector<float>& predicted)
+{
+    std::vector<int> floors;
+    for (int floor = 0; floor < sim.config.numFloors; floor++) {
+        if (predicted[floor] > 0.0f && zoneServesFloor(sim.zones[zone], floor)) floors.push_back(floor);
+    }
+    std::sort(floors.begin(), floors.end(), [&](int a, int b) { return predicted[a] > predicted[b]; });
+
+    int lobby = sim.zones[zone].lobbyFloor;
+    if (sim.dispatch.returnToLobby) {
+        floors.erase(std::remove(floors.begin(), floors.end(), lobby), floors.end());
+        floors.insert(floors.begin(), lobby);
+    }
+
+    std::vector<bool> carTaken(sim.cars.size(), false);
+    for (int i = 0; i < (int)sim.cars.size(); i++) {
+        if (sim.carZone[i] != zone) carTaken[i] = true;
+    }
+
+    for (int floor : floors) {
+        bool covered = false;
+        for (int i = 0; i < (int)sim.cars.size(); i++) {
+            if (sim.carZone[i] != zone) continue;
+            const Elevator& car = sim.cars[i];
+            // Standing here with nothing left to do - doors may still be open from arriving
+            bool parkedHere = isAtStopFor(car, floor) && car.queuedFloors.empty() && sim.riding[i].empty();
+            bool headingHere = sim.carParking[i] && car.targetFloor == stopFloorFor(car, floor);
+            if (parkedHere || headingHere) {
+                covered = true;
+                carTaken[i] = true;
+            }
+        }
+        if (covered) continue;
+
+        int nearest = -1;
+        for (int i = 0; i < (int)sim.cars.size(); i++) {
+            if (carTaken[i] || !isIdle(sim, i) || !carReaches(sim, i, floor)) continue;
+            if (shaftConflict(sim, i, floor) >= 0) continue;
+            if (nearest < 0 || std::abs(sim.cars[i].currentFloor - floor) < std::abs(sim.cars[nearest].currentFloor - floor)) {
+                nearest = i;
+            }
+        }
+        if (nearest < 0) return;     // Every idle car of the zone is placed
+
+        Elevator& car = sim.cars[nearest];
+        startRun(car, stopFloorFor(car, floor));
+        sim.carParking[nearest] = true;
+        carTaken[nearest] = true;
+    }
+}
+
+// Feeds the pattern estimator (destination entry at the landing) and retunes dispatch
+static void observeTrip(Simulation& sim, int origin, int destination)
+{
+    observeCall(sim.traffic, sim.time, origin, destination);
+    if (!sim.config.adaptiveDispatch || sim.time - sim.lastModeSwitch < TRAFFIC_MODE_MIN_DWELL) return;
+
+    TrafficMode mode = classifyTraffic(sim.traffic, sim.time, sim.trafficMode);
+    if (mode != sim.trafficMode) {
+        sim.trafficMode = mode;
+        sim.dispatch = sim.config.dispatchByMode[(int)mode];
+        sim.lastModeSwitch = sim.time;
+        sim.stats.trafficModeSwitches++;
+    }
+}
+
+static void spawnPassenger(Simulation& sim)
+{
+    if (sim.config.numFloors < 2) return;     // No floor to travel to - otherFloor would never return
+    const TrafficProfile& traffic = sim.config.traffic;
+    int lobby = traffic.lobbyFloor;
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_int_distribution<int> anyFloor(0, sim.config.numFloors - 1);
+
+    auto otherFloor = [&](int exclude) {
+        int floor;
+        do { floor = anyFloor(sim.rng); } while (floor == exclude);
+        return floor;
+    };
+
+    int origin, destination;
+    if (unit(sim.rng) < traffic.lobbyOriginShare) {
+        origin = lobby;
+        destination = otherFloor(lobby);
+    } else {
+        origin = otherFloor(lobby);
+        destination = unit(sim.rng) < traffic.lobbyDestinationShare ? lobby : otherFloor(origin);
+    }
+    addPassenger(sim, origin, destination);
+}
+
+int addPassenger(Simulation& sim, int origin, int destination, float weightKg)
+{
+    if (origin == destination || sim.routeZone[origin * sim.config.numFloors + destination] < 0) return -1;    // No zone reaches it
+    std::normal_distribution<float> weight(PASSENGER_WEIGHT_KG, 12.0f);
+
+    Passenger p;
+    p.origin = origin;
+    p.destination = destination;
+    p.weightKg = weightKg > 0.0f ? weightKg : std::min(140.0f, std::max(40.0f, weight(sim.rng)));
+    p.spawnTime = sim.time;
+    p.delivered = false;
+    p.refused = false;
+
+    int id = (int)sim.passengers.size();
+    sim.passengers.push_back(p);
+    sim.stats.spawned++;
+    observeTrip(sim, p.origin, p.destination);
+    beginRide(sim, id, p.origin);
+    return id;
+}
+
+// Energy-saving cars cruise at ECO_SPEED_FACTOR until someone in their zone has waited
+// ENERGY_SAVING_SLACK - then the whole bank needs its capacity back
+static void setCruiseSpeeds(Simulation& sim)
+{
+    std::vector<bool> urgent(sim.zones.size(), false);
+    for (int call = 0; call < (int)sim.waiting.size(); call++) {
+        int zone = call / sim.config.numFloors;
+        if (urgent[zone]) continue;
+        for (int id : sim.waiting[call]) {
+            if (sim.time - sim.passengers[id].callTime > ENERGY_SAVING_SLACK) {
+                urgent[zone] = true;
+                break;
+            }
+        }
+    }
+    for (int i = 0; i < (int)sim.cars.size(); i++) {
+        float factor = urgent[sim.carZone[i]] ? 1.0f : ECO_SPEED_FACTOR;
+        sim.cars[i].speed = sim.config.carSpeed * factor;
+    }
+}
+
+void stepSimulation(Simulation& sim, float deltaTime)
+{
+    sim.time += deltaTime;
+
+    while (sim.time >= sim.nextArrivalTime) {
+        spawnPassenger(sim);
+        sim.nextArrivalTime += sampleInterarrival(sim);
+    }
+    while (sim.nextScheduled < sim.schedule.size() && sim.schedule[sim.nextScheduled].time <= sim.time) {
+        const ScheduledTrip& trip = sim.schedule[sim.nextScheduled++];
+        addPassenger(sim, trip.origin, trip.destination, trip.weightKg);
+    }
+
+    if (sim.config.energySaving) setCruiseSpeeds(sim);
+    for (int i = 0; i < (int)sim.cars.size(); i++) {
+        Elevator& car = sim.cars[i];
+        double used = car.energyUsedJ, recovered = car.energyRecoveredJ;
+        if (scheduleShaftMove(sim, i, deltaTime)) {
+            stepElevator(car, deltaTime);
+        } else {
+            // Held by the shaft - doors still run, but the queue is kept out of reach
+            std::vector<int> held;
+            held.swap(car.queuedFloors);
+            stepElevator(car, deltaTime);
+            car.queuedFloors.swap(held);
+        }
+        sim.stats.energyUsedJ += car.energyUsedJ - used;
+        sim.stats.energyRecoveredJ += car.energyRecoveredJ - recovered;
+
+        bool open = car.doorsOpen && !car.moving;
+        if (open && !sim.carDoorsWereOpen[i]) serveFloor(sim, i);
+        sim.carDoorsWereOpen[i] = open;
+        syncCarEta(sim, i);
+    }
+
+    // Unanswered landings - new calls, or passengers refused by a full car
+    if (sim.config.assignment == AssignmentMethod::Batch) {
+        planHallCalls(sim);
+    } else {
+        for (int zone = 0; zone < (int)sim.zones.size(); zone++) {
+            for (int floor = 0; floor < sim.config.numFloors; floor++) {
+                int call = zone * sim.config.numFloors + floor;
+                if (sim.hallCallCar[call] < 0 && isOpenLanding(sim, zone, floor)) dispatchHallCall(sim, zone, floor);
+            }
+        }
+    }
+
+    bool parking = sim.config.parking == ParkingStrategy::PredictedDemand || sim.dispatch.returnToLobby;
+    if (parking && sim.time >= sim.nextParkingReview) {
+        // Without predictive parking the lobby is the only floor idle cars go to
+        std::vector<float> predicted(sim.config.numFloors, 0.0f);
+        if (sim.config.parking == ParkingStrategy::PredictedDemand) {
+            predicted = predictDemand(sim.demand, timeOfDay(sim), PARKING_HORIZON_SECONDS);
+        }
+        for (int zone = 0; zone < (int)sim.zones.size(); zone++) parkIdleCars(sim, zone, predicted);
+        sim.nextParkingReview = sim.time + PARKING_REVIEW_SECONDS;
+    }
+}
+
+SimStats runSimulation(const SimConfig& config, float duration, float deltaTime)
+{
+    Simulation sim;
+    initSimulation(sim, config);
+    while (sim.time < duration) {
+        stepSimulation(sim, deltaTime);
+    }
+    return sim.stats;
+}
+
+float averageWaitTime(const SimStats& stats)
+{
+    return stats.boarded > 0 ? (float)(stats.totalWaitTime / stats.boarded) : 0.0f;
+}
+
+float energyKWh(const SimStats& stats)
+{
+    return (float)((stats.energyUsedJ - stats.energyRecoveredJ) / 3.6e6);
+}
+
+float energyPerPassengerWh(const SimStats& stats)
+{
+    return stats.delivered > 0 ? energyKWh(stats) * 1000.0f / stats.delivered : 0.0f;
+}
+
+void printSimStats(const SimStats& stats, float duration)
+{
+    float avgWait = averageWaitTime(stats);
+    float avgRide = stats.delivered > 0 ? (float)(stats.totalRideTime / stats.delivered) : 0.0f;
+    float perFiveMinutes = duration > 0.0f ? stats.delivered * 300.0f / duration : 0.0f;
+
+    std::cout << "Passengers:          " << stats.spawned << " spawned, " << stats.delivered << " delivered" << std::endl;
+    std::cout << "Average wait:        " << avgWait << " s (max " << stats.maxWaitTime << " s)" << std::endl;
+    std::cout << "Average ride:        " << avgRide << " s" << std::endl;
+    std::cout << "Handling capacity:   " << perFiveMinutes << " passengers / 5 min" << std::endl;
+    std::cout << "Refused boardings:   " << stats.refusedBoardings << std::endl;
+    std::cout << "Bypassed hall calls: " << stats.bypassedHallCalls << std::endl;
+    std::cout << "Pattern switches:    " << stats.trafficModeSwitches << std::endl;
+    std::cout << "Transfers:           " << stats.transfers << std::endl;
+    std::cout << "Energy:              " << energyKWh(stats) << " kWh net (" << stats.energyRecoveredJ / 3.6e6 << " kWh regenerated), "
+              << energyPerPassengerWh(stats) << " Wh per passenger" << std::endl;
+    if (stats.stairTrips > 0) std::cout << "Stair trips:         " << stats.stairTrips << std::endl;
+    if (stats.shaftYields > 0 || stats.shaftBlockedTime > 0.0f) {
+        std::cout << "Shaft blocking:      " << stats.shaftBlockedTime << " car-s held, " << stats.shaftYields << " step-aside moves" << std::endl;
+    }
+    if (stats.etaQueries > 0) {
+        std::cout << "ETA table:           " << stats.etaEntriesComputed << " entries computed for " << stats.etaQueries << " dispatch queries" << std::endl;
+    }
+}
@@ -0,0 +1,129 @@
+#include "../Header/Sweep.h"
+#include "../Header/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+SweepSpec defaultSweepSpec()
+{
+    SweepSpec spec;
+    spec.floors = {8, 16};
+    spec.cars = {2, 3, 4};
+    spec.speeds = {2.0f, 3.0f, 5.0f};
+    spec.doorOpenTimes = {3.0f, 5.0f, 7.0f};
+    spec.capacities = {8, 13};
+    spec.assignments = {AssignmentMethod::Greedy, AssignmentMethod::Batch};
+    spec.randomSamples = 0;
+    spec.duration = 3600.0f;
+    spec.timeStep = 1.0f / 75.0f;
+    spec.seed = 2024;
+    return spec;
+}
+
+// One bank serving every floor, with traffic growing with the building
+static SimConfig sweepConfig(int floors, int cars, float speed, float doorOpenTime, int capacity, AssignmentMethod assignment)
+{
+    SimConfig config = defaultSimConfig();
+    config.numFloors = floors;
+    config.numCars = cars;
+    config.carSpeed = speed;
+    config.doorOpenTime = doorOpenTime;
+    config.doorExtendedTime = doorOpenTime * DOOR_EXTENDED_TIME / DOOR_OPEN_TIME;
+    config.capacityPersons = capacity;
+    config.capacityKg = capacity * ELEVATOR_CAPACITY_KG / ELEVATOR_CAPACITY_PERSONS;
+    config.assignment = assignment;
+    config.traffic.arrivalsPerMinute *= (float)floors / NUM_FLOORS;
+    return config;
+}
+
+std::vector<SimConfig> sweepConfigs(const SweepSpec& spec)
+{
+    std::vector<SimConfig> configs;
+    if (spec.randomSamples <= 0) {
+        for (int floors : spec.floors)
+        for (int cars : spec.cars)
+        for (float speed : spec.speeds)
+        for (float door : spec.doorOpenTimes)
+        for (int capacity : spec.capacities)
+        for (AssignmentMethod assignment : spec.assignments) {
+            configs.push_back(sweepConfig(floors, cars, speed, door, capacity, assignment));
+        }
+        return configs;
+    }
+
+    std::mt19937 rng(spec.seed);
+    auto intIn = [&](const std::vector<int>& values) {
+        auto range = std::minmax_element(values.begin(), values.end());
+        return std::uniform_int_distribution<int>(*range.first, *range.second)(rng);
+    };
+    auto floatIn = [&](const std::vector<float>& values) {
+        auto range = std::minmax_element(values.begin(), values.end());
+        return std::uniform_real_distribution<float>(*range.first, *range.second)(rng);
+    };
+    for (int i = 0; i < spec.randomSamples; i++) {
+        int floors = intIn(spec.floors);
+        int cars = intIn(spec.cars);
+        float speed = floatIn(spec.speeds);
+        float door = floatIn(spec.doorOpenTimes);
+        int capacity = intIn(spec.capacities);
+        AssignmentMethod assignment = spec.assignments[rng() % spec.assignments.size()];
+        configs.push_back(sweepConfig(floors, cars, speed, door, capacity, assignment));
+    }
+    return configs;
+}
+
+struct SweepResult {
+    SimStats stats;
+    double runMs;
+};
+
+bool runSweep(const SweepSpec& spec, int threads, const char* outputPath)
+{
+    std::vector<SimConfig> configs = sweepConfigs(spec);
+    std::vector<SweepResult> results(configs.size());
+
+    std::ofstream file;
+    if (outputPath) {
+        file.open(outputPath);
+        if (!file) {
+            std::cout << "Could not open " << outputPath << std::endl;
+            return false;
+        }
+    }
+    std::ostream& out = outputPath ? file : std::cout;
+
+    ThreadPool pool;
+    startThreadPool(pool, threads);
+    int workers = (int)pool.workers.size();
+    auto start = std::chrono::steady_clock::now();
+    runJobs(pool, (int)configs.size(), [&](int i) {
+        auto jobStart = std::chrono::steady_clock::now();
+        results[i].stats = runSimulation(configs[i], spec.duration, spec.timeStep);
+        results[i].runMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - jobStart).count();
+    });
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    long long steals = pool.steals;
+    stopThreadPool(pool);
+
+    out << "index,floors,cars,speed,door_open_s,door_extended_s,capacity_persons,capacity_kg,assignment,arrivals_per_min,"
+           "spawned,delivered,avg_wait_s,max_wait_s,avg_ride_s,wh_per_passenger,run_ms" << std::endl;
+    double busyMs = 0.0;
+    for (size_t i = 0; i < configs.size(); i++) {
+        const SimConfig& c = configs[i];
+        const SimStats& s = results[i].stats;
+        float avgRide = s.delivered > 0 ? (float)(s.totalRideTime / s.delivered) : 0.0f;
+        out << i << ',' << c.numFloors << ',' << c.numCars << ',' << c.carSpeed << ',' << c.doorOpenTime << ','
+            << c.doorExtendedTime << ',' << c.capacityPersons << ',' << c.capacityKg << ','
+            << (c.assignment == AssignmentMethod::Batch ? "batch" : "greedy") << ',' << c.traffic.arrivalsPerMinute << ','
+            << s.spawned << ',' << s.delivered << ',' << averageWaitTime(s) << ',' << s.maxWaitTime << ',' << avgRide << ','
+            << energyPerPassengerWh(s) << ',' << results[i].runMs << std::endl;
+        busyMs += results[i].runMs;
+    }
+
+    std::cout << configs.size() << " configurations on " << workers << " threads in " << wallMs / 1000.0 << " s ("
+              << "job time " << busyMs / std::max(1.0, wallMs) << "x wall time, " << steals << " jobs stolen)" << std::endl;
+    return true;
+}
@@ -0,0 +1,94 @@
+#include "../Header/ThreadPool.h"
+
+static bool takeJob(ThreadPool& pool, int self, std::function<void()>& job)
+{
+    int n = (int)pool.queues.size();
+    for (int k = 0; k < n; k++) {
+        WorkQueue& queue = *pool.queues[(self + k) % n];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.jobs.empty()) continue;
+
+        // Own work newest first, stolen work oldest first
+        if (k == 0) {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        } else {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+            pool.steals++;
+        }
+        pool.queued--;
+        return true;
+    }
+    return false;
+}
+
+static void workerLoop(ThreadPool& pool, int self)
+{
+    for (;;) {
+        std::function<void()> job;
+        if (takeJob(pool, self, job)) {
+            job();
+            if (--pool.pending == 0) {
+                std::lock_guard<std::mutex> guard(pool.idleLock);
+                pool.done.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(pool.idleLock);
+        pool.wake.wait(lock, [&] { return pool.stopping || pool.queued > 0; });
+        if (pool.stopping && pool.queued <= 0) return;
+    }
+}
+
+void startThreadPool(ThreadPool& pool, int numThreads)
+{
+    if (numThreads <= 0) numThreads = (int)std::thread::hardware_concurrency();
+    if (numThreads <= 0) numThreads = 1;
+
+    pool.stopping = false;
+    pool.queues.clear();
+    for (int i = 0; i < numThreads; i++) pool.queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+    for (int i = 0; i < numThreads; i++) pool.workers.push_back(std::thread(workerLoop, std::ref(pool), i));
+}
+
+void stopThreadPool(ThreadPool& pool)
+{
+    {
+        std::lock_guard<std::mutex> guard(pool.idleLock);
+        pool.stopping = true;
+    }
+    pool.wake.notify_all();
+    for (std::thread& worker : pool.workers) worker.join();
+    pool.workers.clear();
+    pool.queues.clear();
+}
+
+void submitJob(ThreadPool& pool, std::function<void()> job)
+{
+    pool.pending++;
+    WorkQueue& queue = *pool.queues[pool.nextQueue];
+    pool.nextQueue = (pool.nextQueue + 1) % (int)pool.queues.size();
+    {
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.jobs.push_back(std::move(job));
+    }
+    {
+        std::lock_guard<std::mutex> guard(pool.idleLock);
+        pool.queued++;
+    }
+    pool.wake.notify_one();
+}
+
+void waitForJobs(ThreadPool& pool)
+{
+    std::unique_lock<std::mutex> lock(pool.idleLock);
+    pool.done.wait(lock, [&] { return pool.pending == 0; });
+}
+
+void runJobs(ThreadPool& pool, int count, const std::function<void(int)>& job)
+{
+    for (int i = 0; i < count; i++) submitJob(pool, [&job, i] { job(i); });
+    waitForJobs(pool);
+}
@@ -0,0 +1,411 @@
+#include "../Header/Trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+static const char TRACE_MAGIC[4] = {'K', 'T', 'R', 'C'};
+
+// 64-bit offsets - long is 32 bits on Windows, which would stop traces at 2 GB
+static int seekFile(FILE* file, int64_t offset, int origin)
+{
+#ifdef _WIN32
+    return _fseeki64(file, offset, origin);
+#else
+    return fseeko(file, (off_t)offset, origin);
+#endif
+}
+
+enum TraceRecordKind : uint8_t {
+    TRACE_KEYFRAME = 1,
+    TRACE_DELTA = 2
+};
+
+template <typename T>
+static void put(std::vector<unsigned char>& out, const T& value)
+{
+    size_t at = out.size();
+    out.resize(at + sizeof(T));
+    memcpy(out.data() + at, &value, sizeof(T));
+}
+
+template <typename T>
+static T get(const unsigned char*& p)
+{
+    T value;
+    memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return value;
+}
+
+static void setStop(TraceCar& car, int floor)
+{
+    car.stops[floor / 64] |= 1ull << (floor % 64);
+}
+
+bool traceStopsAt(const TraceCar& car, int floor)
+{
+    return (car.stops[floor / 64] >> (floor % 64)) & 1;
+}
+
+void captureTraceFrame(const Simulation& sim, TraceFrame& frame)
+{
+    frame.cars.resize(sim.cars.size());
+    for (size_t i = 0; i < sim.cars.size(); i++) {
+        const Elevator& car = sim.cars[i];
+        TraceCar& out = frame.cars[i];
+        memset(&out, 0, sizeof(TraceCar));
+        out.y = car.y;
+        out.currentFloor = (int16_t)car.currentFloor;
+        out.targetFloor = (int16_t)(car.moving ? car.targetFloor : car.currentFloor);
+        out.passengers = (int16_t)std::min(car.passengerCount, 32767);
+        out.flags = (car.moving ? TRACE_MOVING : 0) | (car.doorsOpen ? TRACE_DOORS_OPEN : 0) | (car.decks > 1 ? TRACE_DOUBLE_DECK : 0);
+        if (car.moving) setStop(out, car.targetFloor);
+        for (int floor : car.queuedFloors) setStop(out, floor);
+    }
+
+    int numFloors = sim.config.numFloors;
+    frame.waiting.assign(numFloors, 0);
+    for (size_t call = 0; call < sim.waiting.size(); call++) {
+        uint16_t& count = frame.waiting[call % numFloors];
+        count = (uint16_t)std::min<size_t>(count + sim.waiting[call].size(), 65535);
+    }
+}
+
+void applyTraceCar(const TraceCar& car, Elevator& elevator)
+{
+    elevator.y = car.y;
+    elevator.currentFloor = car.currentFloor;
+    elevator.moving = (car.flags & TRACE_MOVING) != 0;
+    elevator.doorsOpen = (car.flags & TRACE_DOORS_OPEN) != 0;
+    elevator.decks = (car.flags & TRACE_DOUBLE_DECK) ? MAX_DECKS : 1;
+    elevator.passengerCount = car.passengers;
+    elevator.queuedFloors.clear();
+    for (int floor = 0; floor < TRACE_STOP_WORDS * 64; floor++) {
+        if (traceStopsAt(car, floor)) elevator.queuedFloors.push_back(floor);
+    }
+    // The stop bits include the target - the car serves its queue in call order, so it may pass nearer stops
+    elevator.targetFloor = car.targetFloor;
+    if (elevator.moving) {
+        std::vector<int>& queue = elevator.queuedFloors;
+        queue.erase(std::remove(queue.begin(), queue.end(), elevator.targetFloor), queue.end());
+    }
+}
+
+// ----- Writing -----
+
+static bool writeRecord(TraceWriter& writer)
+{
+    size_t written = fwrite(writer.record.data(), 1, writer.record.size(), writer.file);
+    writer.offset += written;
+    return written == writer.record.size();
+}
+
+static void writeKeyframe(TraceWriter& writer, const TraceFrame& frame)
+{
+    writer.index.push_back({writer.sample, 0, writer.offset});
+    writer.record.clear();
+    put<uint8_t>(writer.record, TRACE_KEYFRAME);
+    put<uint32_t>(writer.record, writer.sample);
+    for (const TraceCar& car : frame.cars) put(writer.record, car);
+    for (uint16_t count : frame.waiting) put(writer.record, count);
+    writer.keyframeBytes += writer.record.size();
+    writeRecord(writer);
+}
+
+static void writeDelta(TraceWriter& writer, const TraceFrame& last, const TraceFrame& frame)
+{
+    std::vector<unsigned char>& out = writer.record;
+    out.clear();
+    put<uint8_t>(out, TRACE_DELTA);
+    put<uint32_t>(out, writer.sample);
+
+    size_t carCountAt = out.size();
+    put<uint16_t>(out, 0);
+    uint16_t cars = 0;
+    for (size_t i = 0; i < frame.cars.size(); i++) {
+        const TraceCar& a = last.cars[i];
+        const TraceCar& b = frame.cars[i];
+        uint8_t mask = 0;
+        if (a.y != b.y) mask |= TRACE_FIELD_Y;
+        if (a.currentFloor != b.currentFloor || a.targetFloor != b.targetFloor || a.passengers != b.passengers || a.flags != b.flags) {
+            mask |= TRACE_FIELD_STATE;
+        }
+        if (memcmp(a.stops, b.stops, sizeof(a.stops)) != 0) mask |= TRACE_FIELD_STOPS;
+        if (!mask) continue;
+
+        put<uint16_t>(out, (uint16_t)i);
+        put<uint8_t>(out, mask);
+        if (mask & TRACE_FIELD_Y) put(out, b.y);
+        if (mask & TRACE_FIELD_STATE) {
+            put(out, b.currentFloor);
+            put(out, b.targetFloor);
+            put(out, b.passengers);
+            put(out, b.flags);
+        }
+        if (mask & TRACE_FIELD_STOPS) put(out, b.stops);
+        cars++;
+    }
+
+    size_t floorCountAt = out.size();
+    put<uint16_t>(out, 0);
+    uint16_t floors = 0;
+    for (size_t floor = 0; floor < frame.waiting.size(); floor++) {
+        if (frame.waiting[floor] == last.waiting[floor]) continue;
+        put<uint16_t>(out, (uint16_t)floor);
+        put<uint16_t>(out, frame.waiting[floor]);
+        floors++;
+    }
+
+    if (cars == 0 && floors == 0) return;   // Nothing happened - the sample is left out
+    memcpy(out.data() + carCountAt, &cars, sizeof(cars));
+    memcpy(out.data() + floorCountAt, &floors, sizeof(floors));
+    writer.deltaBytes += out.size();
+    writeRecord(writer);
+}
+
+bool openTraceWriter(TraceWriter& writer, const char* path, const Simulation& sim)
+{
+    writer.file = fopen(path, "wb");
+    if (!writer.file) {
+        std::cout << "Could not open " << path << std::endl;
+        return false;
+    }
+
+    TraceHeader& header = writer.header;
+    memcpy(header.magic, TRACE_MAGIC, 4);
+    header.version = TRACE_VERSION;
+    header.numFloors = sim.config.numFloors;
+    header.numCars = (int32_t)sim.cars.size();
+    header.sampleInterval = TRACE_SAMPLE_INTERVAL;
+    header.keyframeInterval = TRACE_KEYFRAME_INTERVAL;
+    header.startTimeOfDay = sim.config.startTimeOfDay;
+    fwrite(&header, sizeof(header), 1, writer.file);
+
+    writer.samplesPerKeyframe = (uint32_t)std::max(1.0f, std::round(TRACE_KEYFRAME_INTERVAL / TRACE_SAMPLE_INTERVAL));
+    writer.sample = 0;
+    writer.index.clear();
+    writer.offset = sizeof(header);
+    writer.keyframeBytes = 0;
+    writer.deltaBytes = 0;
+    return true;
+}
+
+void writeTraceSample(TraceWriter& writer, const Simulation& sim)
+{
+    captureTraceFrame(sim, writer.current);
+    if (writer.sample % writer.samplesPerKeyframe == 0) writeKeyframe(writer, writer.current);
+    else writeDelta(writer, writer.last, writer.current);
+    writer.last.cars.swap(writer.current.cars);
+    writer.last.waiting.swap(writer.current.waiting);
+    writer.sample++;
+}
+
+bool closeTraceWriter(TraceWriter& writer)
+{
+    TraceFooter footer;
+    footer.indexOffset = writer.offset;
+    footer.keyframes = (uint32_t)writer.index.size();
+    memcpy(footer.magic, TRACE_MAGIC, 4);
+    fwrite(writer.index.data(), sizeof(TraceIndexEntry), writer.index.size(), writer.file);
+    fwrite(&footer, sizeof(footer), 1, writer.file);
+    bool ok = !ferror(writer.file);
+    fclose(writer.file);
+    writer.file = nullptr;
+    return ok;
+}
+
+// ----- Reading -----
+
+bool openTrace(TraceReader& reader, const char* path)
+{
+    reader.file = fopen(path, "rb");
+    if (!reader.file) {
+        std::cout << "Could not open " << path << std::endl;
+        return false;
+    }
+
+    TraceFooter footer;
+    bool ok = fread(&reader.header, sizeof(reader.header), 1, reader.file) == 1 &&
+              memcmp(reader.header.magic, TRACE_MAGIC, 4) == 0 && reader.header.version == TRACE_VERSION &&
+              seekFile(reader.file, -(int64_t)sizeof(footer), SEEK_END) == 0 &&
+              fread(&footer, sizeof(footer), 1, reader.file) == 1 && memcmp(footer.magic, TRACE_MAGIC, 4) == 0 &&
+              footer.keyframes > 0;
+    if (ok) {
+        reader.index.resize(footer.keyframes);
+        reader.indexOffset = footer.indexOffset;
+        ok = seekFile(reader.file, (int64_t)footer.indexOffset, SEEK_SET) == 0 &&
+             fread(reader.index.data(), sizeof(TraceIndexEntry), footer.keyframes, reader.file) == footer.keyframes;
+    }
+    if (!ok) {
+        std::cout << path << " is not a complete trace" << std::endl;
+        fclose(reader.file);
+        reader.file = nullptr;
+        return false;
+    }
+
+    reader.segment = -1;
+    reader.position = 0;
+    reader.segmentsLoaded = 0;
+    reader.frame.cars.resize(reader.header.numCars);
+    reader.frame.waiting.resize(reader.header.numFloors);
+    seekTrace(reader, 0.0f);
+    return true;
+}
+
+void closeTrace(TraceReader& reader)
+{
+    if (reader.file) fclose(reader.file);
+    reader.file = nullptr;
+}
+
+float traceDuration(const TraceReader& reader)
+{
+    uint32_t last = reader.index.back().sample + (uint32_t)std::round(reader.header.keyframeInterval / reader.header.sampleInterval);
+    return last * reader.header.sampleInterval;
+}
+
+// Reads keyframe segment k and applies its keyframe
+static void loadSegment(TraceReader& reader, int k)
+{
+    uint64_t begin = reader.index[k].offset;
+    uint64_t end = k + 1 < (int)reader.index.size() ? reader.index[k + 1].offset : reader.indexOffset;
+    reader.bytes.resize((size_t)(end - begin));
+    seekFile(reader.file, (int64_t)begin, SEEK_SET);
+    size_t got = fread(reader.bytes.data(), 1, reader.bytes.size(), reader.file);
+    reader.bytes.resize(got);
+    reader.segment = k;
+    reader.segmentsLoaded++;
+}
+
+static void applyKeyframe(TraceReader& reader)
+{
+    const unsigned char* p = reader.bytes.data();
+    p += sizeof(uint8_t);
+    reader.frame.sample = get<uint32_t>(p);
+    for (TraceCar& car : reader.frame.cars) car = get<TraceCar>(p);
+    for (uint16_t& count : reader.frame.waiting) count = get<uint16_t>(p);
+    reader.position = p - reader.bytes.data();
+}
+
+static void applyDelta(TraceReader& reader, const unsigned char*& p)
+{
+    p += sizeof(uint8_t);
+    reader.frame.sample = get<uint32_t>(p);
+    uint16_t cars = get<uint16_t>(p);
+    for (uint16_t n = 0; n < cars; n++) {
+        TraceCar& car = reader.frame.cars[get<uint16_t>(p)];
+        uint8_t mask = get<uint8_t>(p);
+        if (mask & TRACE_FIELD_Y) car.y = get<float>(p);
+        if (mask & TRACE_FIELD_STATE) {
+            car.currentFloor = get<int16_t>(p);
+            car.targetFloor = get<int16_t>(p);
+            car.passengers = get<int16_t>(p);
+            car.flags = get<uint8_t>(p);
+        }
+        if (mask & TRACE_FIELD_STOPS) {
+            for (uint64_t& word : car.stops) word = get<uint64_t>(p);
+        }
+    }
+    uint16_t floors = get<uint16_t>(p);
+    for (uint16_t n = 0; n < floors; n++) {
+        uint16_t floor = get<uint16_t>(p);
+        reader.frame.waiting[floor] = get<uint16_t>(p);
+    }
+}
+
+void seekTrace(TraceReader& reader, float time)
+{
+    uint32_t sample = (uint32_t)std::max(0.0f, time / reader.header.sampleInterval);
+    auto after = std::upper_bound(reader.index.begin(), reader.index.end(), sample,
+                                  [](uint32_t s, const TraceIndexEntry& entry) { return s < entry.sample; });
+    int k = std::max(0, (int)(after - reader.index.begin()) - 1);
+
+    // Playing forward stays in the loaded segment and continues from the last delta
+    if (k != reader.segment) {
+        loadSegment(reader, k);
+        applyKeyframe(reader);
+    } else if (sample < reader.frame.sample) {
+        applyKeyframe(reader);
+    }
+
+    const unsigned char* p = reader.bytes.data() + reader.position;
+    const unsigned char* end = reader.bytes.data() + reader.bytes.size();
+    while (p < end) {
+        uint32_t next;
+        memcpy(&next, p + sizeof(uint8_t), sizeof(next));
+        if (next > sample) break;
+        applyDelta(reader, p);
+    }
+    reader.position = p - reader.bytes.data();
+}
+
+// ----- Recording -----
+
+bool recordTrace(const SimConfig& config, float duration, float deltaTime, const char* path)
+{
+    Simulation sim;
+    initSimulation(sim, config);
+    TraceWriter writer;
+    if (!openTraceWriter(writer, path, sim)) return false;
+
+    auto start = std::chrono::steady_clock::now();
+    double nextSample = 0.0;
+    uint32_t samples = (uint32_t)(duration / TRACE_SAMPLE_INTERVAL);
+    while (writer.sample < samples) {
+        while (writer.sample < samples && sim.time >= nextSample) {
+            writeTraceSample(writer, sim);
+            nextSample = writer.sample * (double)TRACE_SAMPLE_INTERVAL;
+        }
+        stepSimulation(sim, std::min(deltaTime, TRACE_SAMPLE_INTERVAL));
+    }
+    bool ok = closeTraceWriter(writer);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double megabytes = (writer.offset + writer.index.size() * sizeof(TraceIndexEntry)) / (1024.0 * 1024.0);
+    std::cout << "Recorded " << duration / 3600.0f << " h to " << path << " in " << seconds << " s: " << megabytes << " MB, "
+              << writer.index.size() << " keyframes (" << writer.keyframeBytes / 1024 << " KB), deltas "
+              << writer.deltaBytes / 1024 << " KB" << std::endl;
+    std::cout << "Passengers:          " << sim.stats.spawned << " spawned, " << sim.stats.delivered << " delivered" << std::endl;
+    return ok;
+}
+
+void benchmarkTraceSeeks(const char* path, int seeks)
+{
+    TraceReader reader;
+    if (!openTrace(reader, path)) return;
+
+    float duration = traceDuration(reader);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> anyTime(0.0f, duration);
+    double worstMs = 0.0, totalMs = 0.0;
+    for (int i = 0; i < seeks; i++) {
+        auto start = std::chrono::steady_clock::now();
+        seekTrace(reader, anyTime(rng));
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        totalMs += ms;
+        worstMs = std::max(worstMs, ms);
+    }
+
+    // Against replaying every delta from the start up to the end of the trace
+    auto start = std::chrono::steady_clock::now();
+    long long deltas = 0;
+    for (int k = 0; k < (int)reader.index.size(); k++) {
+        loadSegment(reader, k);
+        applyKeyframe(reader);
+        const unsigned char* p = reader.bytes.data() + reader.position;
+        const unsigned char* end = reader.bytes.data() + reader.bytes.size();
+        while (p < end) {
+            applyDelta(reader, p);
+            deltas++;
+        }
+    }
+    double fullMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << seeks << " random seeks over " << duration / 3600.0f << " h: average " << totalMs / seeks << " ms, worst "
+              << worstMs << " ms (reading the whole trace: " << fullMs << " ms, " << deltas << " deltas)" << std::endl;
+    closeTrace(reader);
+}
@@ -0,0 +1,90 @@
+#include "../Header/Traffic.h"
+
+#include <cmath>
+
+// Scale exponent at which the stored weights are folded back to the current epoch
+static const float RENORMALISE_EXPONENT = 60.0f;
+
+void initTrafficEstimator(TrafficEstimator& estimator, int lobbyFloor, float timeConstant)
+{
+    estimator.lobbyFloor = lobbyFloor;
+    estimator.timeConstant = timeConstant;
+    estimator.epoch = 0.0f;
+    for (int i = 0; i < TRAFFIC_MAX_FLOORS; i++) {
+        for (int j = 0; j < TRAFFIC_MAX_FLOORS; j++) estimator.od[i][j] = 0.0f;
+    }
+    estimator.total = 0.0;
+    estimator.fromLobby = 0.0;
+    estimator.toLobby = 0.0;
+}
+
+static void renormalise(TrafficEstimator& estimator, float time)
+{
+    float decay = std::exp(-(time - estimator.epoch) / estimator.timeConstant);
+    for (int i = 0; i < TRAFFIC_MAX_FLOORS; i++) {
+        for (int j = 0; j < TRAFFIC_MAX_FLOORS; j++) estimator.od[i][j] *= decay;
+    }
+    estimator.total *= decay;
+    estimator.fromLobby *= decay;
+    estimator.toLobby *= decay;
+    estimator.epoch = time;
+}
+
+void observeCall(TrafficEstimator& estimator, float time, int origin, int destination)
+{
+    if (origin < 0 || origin >= TRAFFIC_MAX_FLOORS || destination < 0 || destination >= TRAFFIC_MAX_FLOORS) return;
+
+    float exponent = (time - estimator.epoch) / estimator.timeConstant;
+    if (exponent > RENORMALISE_EXPONENT) {
+        renormalise(estimator, time);
+        exponent = 0.0f;
+    }
+
+    float weight = std::exp(exponent);
+    estimator.od[origin][destination] += weight;
+    estimator.total += weight;
+    if (origin == estimator.lobbyFloor) estimator.fromLobby += weight;
+    if (destination == estimator.lobbyFloor) estimator.toLobby += weight;
+}
+
+// Converts stored weights into decayed call counts at "time"
+static double decayAt(const TrafficEstimator& estimator, float time)
+{
+    return std::exp(-(double)(time - estimator.epoch) / estimator.timeConstant);
+}
+
+float estimatedRate(const TrafficEstimator& estimator, float time, int origin, int destination)
+{
+    if (origin < 0 || origin >= TRAFFIC_MAX_FLOORS || destination < 0 || destination >= TRAFFIC_MAX_FLOORS) return 0.0f;
+    return (float)(estimator.od[origin][destination] * decayAt(estimator, time) / estimator.timeConstant);
+}
+
+float estimatedTotalRate(const TrafficEstimator& estimator, float time)
+{
+    return (float)(estimator.total * decayAt(estimator, time) / estimator.timeConstant);
+}
+
+TrafficMode classifyTraffic(const TrafficEstimator& estimator, float time, TrafficMode current)
+{
+    if (estimator.total * decayAt(estimator, time) < TRAFFIC_MIN_CALLS) return current;
+
+    // Shares are ratios of identically scaled sums, so no decay is needed
+    double up = estimator.fromLobby / estimator.total;
+    double down = estimator.toLobby / estimator.total;
+
+    if (up >= 0.6) return TrafficMode::UpPeak;
+    if (down >= 0.6) return TrafficMode::DownPeak;
+    if (up >= 0.25 && down >= 0.25) return TrafficMode::TwoWay;
+    return TrafficMode::Interfloor;
+}
+
+const char* trafficModeName(TrafficMode mode)
+{
+    switch (mode) {
+    case TrafficMode::UpPeak: return "up-peak";
+    case TrafficMode::DownPeak: return "down-peak";
+    case TrafficMode::TwoWay: return "two-way";
+    case TrafficMode::Interfloor: return "interfloor";
+    }
+    return "unknown";
+}
@@ -0,0 +1,305 @@
+#include "../Header/Transform.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+void composeTransforms(const Mat4& parent, const Mat4* locals, Mat4* out, int count)
+{
+#if defined(MATH_SSE)
+    // Parent columns stay in registers over the whole batch
+    __m128 c0 = _mm_load_ps(parent.m), c1 = _mm_load_ps(parent.m + 4);
+    __m128 c2 = _mm_load_ps(parent.m + 8), c3 = _mm_load_ps(parent.m + 12);
+    for (int i = 0; i < count; i++) {
+        const float* local = locals[i].m;
+        float* result = out[i].m;
+        for (int j = 0; j < 4; j++) {
+            const float* b = local + j*4;
+            __m128 column = _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(b[0])), _mm_mul_ps(c1, _mm_set1_ps(b[1])));
+            column = _mm_add_ps(column, _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(b[2])), _mm_mul_ps(c3, _mm_set1_ps(b[3]))));
+            _mm_store_ps(result + j*4, column);
+        }
+    }
+#else
+    for (int i = 0; i < count; i++) out[i] = parent * locals[i];
+#endif
+}
+
+void placeTransforms(const Vec3* positions, const float* yaws, const Vec3* sizes, Mat4* out, int count)
+{
+    for (int i = 0; i < count; i++) out[i] = Mat4::placement(positions[i], yaws[i], sizes[i]);
+}
+
+#if defined(MATH_SSE)
+static inline __m128 cross(__m128 a, __m128 b)
+{
+    __m128 ayzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 byzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 product = _mm_sub_ps(_mm_mul_ps(a, byzx), _mm_mul_ps(ayzx, b));
+    return _mm_shuffle_ps(product, product, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+// Rows of the upper 3x3 inverse are the cross products of its columns over
+// the determinant; returns false for a singular matrix
+static bool inverseRows(const Mat4& mat, __m128 rows[3])
+{
+    __m128 a = _mm_load_ps(mat.m), b = _mm_load_ps(mat.m + 4), c = _mm_load_ps(mat.m + 8);
+    rows[0] = cross(b, c);
+    rows[1] = cross(c, a);
+    rows[2] = cross(a, b);
+    __m128 products = _mm_mul_ps(a, rows[0]);
+    float det = _mm_cvtss_f32(products) + _mm_cvtss_f32(_mm_shuffle_ps(products, products, _MM_SHUFFLE(1, 1, 1, 1))) +
+                _mm_cvtss_f32(_mm_shuffle_ps(products, products, _MM_SHUFFLE(2, 2, 2, 2)));
+    if (det == 0.0f) return false;
+    __m128 invDet = _mm_set1_ps(1.0f / det);
+    for (int i = 0; i < 3; i++) rows[i] = _mm_mul_ps(rows[i], invDet);
+    return true;
+}
+
+Mat4 affineInverse(const Mat4& mat)
+{
+    __m128 rows[3];
+    if (!inverseRows(mat, rows)) return Mat4();
+
+    // The rows become columns, and the translation goes back through them
+    __m128 r0 = rows[0], r1 = rows[1], r2 = rows[2], r3 = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    __m128 t = _mm_mul_ps(r0, _mm_set1_ps(mat.m[12]));
+    t = _mm_add_ps(t, _mm_mul_ps(r1, _mm_set1_ps(mat.m[13])));
+    t = _mm_add_ps(t, _mm_mul_ps(r2, _mm_set1_ps(mat.m[14])));
+    t = _mm_sub_ps(_mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f), t);
+
+    Mat4 result;
+    _mm_store_ps(result.m, r0);
+    _mm_store_ps(result.m + 4, r1);
+    _mm_store_ps(result.m + 8, r2);
+    _mm_store_ps(result.m + 12, t);
+    return result;
+}
+
+Mat4 normalMatrix(const Mat4& mat)
+{
+    __m128 rows[3];
+    if (!inverseRows(mat, rows)) return Mat4();
+
+    // Transposing the inverse turns its rows into columns
+    Mat4 result;
+    for (int i = 0; i < 3; i++) _mm_store_ps(result.m + i*4, rows[i]);
+    return result;
+}
+#else
+// Rows of the upper 3x3 inverse are the cross products of its columns over
+// the determinant; returns false for a singular matrix
+static bool inverseRows(const float* m, float rows[9])
+{
+    rows[0] = m[5]*m[10] - m[6]*m[9];   // b x c
+    rows[1] = m[6]*m[8] - m[4]*m[10];
+    rows[2] = m[4]*m[9] - m[5]*m[8];
+    rows[3] = m[9]*m[2] - m[10]*m[1];   // c x a
+    rows[4] = m[10]*m[0] - m[8]*m[2];
+    rows[5] = m[8]*m[1] - m[9]*m[0];
+    rows[6] = m[1]*m[6] - m[2]*m[5];    // a x b
+    rows[7] = m[2]*m[4] - m[0]*m[6];
+    rows[8] = m[0]*m[5] - m[1]*m[4];
+    float det = m[0]*rows[0] + m[1]*rows[1] + m[2]*rows[2];
+    if (det == 0.0f) return false;
+    float invDet = 1.0f / det;
+    for (int i = 0; i < 9; i++) rows[i] *= invDet;
+    return true;
+}
+
+Mat4 affineInverse(const Mat4& mat)
+{
+    const float* m = mat.m;
+    float rows[9];
+    if (!inverseRows(m, rows)) return Mat4();
+
+    Mat4 result;
+    float* out = result.m;
+    out[0] = rows[0]; out[4] = rows[1]; out[8] = rows[2];
+    out[1] = rows[3]; out[5] = rows[4]; out[9] = rows[5];
+    out[2] = rows[6]; out[6] = rows[7]; out[10] = rows[8];
+    out[12] = -(rows[0]*m[12] + rows[1]*m[13] + rows[2]*m[14]);
+    out[13] = -(rows[3]*m[12] + rows[4]*m[13] + rows[5]*m[14]);
+    out[14] = -(rows[6]*m[12] + rows[7]*m[13] + rows[8]*m[14]);
+    return result;
+}
+
+Mat4 normalMatrix(const Mat4& mat)
+{
+    float rows[9];
+    if (!inverseRows(mat.m, rows)) return Mat4();
+
+    // Transposing the inverse turns its rows into columns
+    Mat4 result;
+    float* out = result.m;
+    out[0] = rows[0]; out[1] = rows[1]; out[2] = rows[2];
+    out[4] = rows[3]; out[5] = rows[4]; out[6] = rows[5];
+    out[8] = rows[6]; out[9] = rows[7]; out[10] = rows[8];
+    return result;
+}
+#endif
+
+// The code the kernels replace, kept for the benchmark
+
+static Mat4 multiplyScalar(const Mat4& a, const Mat4& b)
+{
+    Mat4 result;
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            result.m[i + j*4] = 0;
+            for (int k = 0; k < 4; k++) {
+                result.m[i + j*4] += a.m[i + k*4] * b.m[k + j*4];
+            }
+        }
+    }
+    return result;
+}
+
+static Vec3 normalizeScalar(const Vec3& v)
+{
+    float len = v.length();
+    if (len > 0) return Vec3(v.x/len, v.y/len, v.z/len);
+    return Vec3(0, 0, 0);
+}
+
+// Full 4x4 inverse from 2x2 sub-determinants, what GLSL's inverse() does per vertex
+static Mat4 generalInverse(const Mat4& mat)
+{
+    const float* a = mat.m;
+    float s0 = a[0]*a[5] - a[4]*a[1], s1 = a[0]*a[6] - a[4]*a[2], s2 = a[0]*a[7] - a[4]*a[3];
+    float s3 = a[1]*a[6] - a[5]*a[2], s4 = a[1]*a[7] - a[5]*a[3], s5 = a[2]*a[7] - a[6]*a[3];
+    float c5 = a[10]*a[15] - a[14]*a[11], c4 = a[9]*a[15] - a[13]*a[11], c3 = a[9]*a[14] - a[13]*a[10];
+    float c2 = a[8]*a[15] - a[12]*a[11], c1 = a[8]*a[14] - a[12]*a[10], c0 = a[8]*a[13] - a[12]*a[9];
+    float det = s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+    if (det == 0.0f) return Mat4();
+    float invDet = 1.0f / det;
+
+    Mat4 result;
+    float* b = result.m;
+    b[0] = ( a[5]*c5 - a[6]*c4 + a[7]*c3) * invDet;
+    b[1] = (-a[1]*c5 + a[2]*c4 - a[3]*c3) * invDet;
+    b[2] = ( a[13]*s5 - a[14]*s4 + a[15]*s3) * invDet;
+    b[3] = (-a[9]*s5 + a[10]*s4 - a[11]*s3) * invDet;
+    b[4] = (-a[4]*c5 + a[6]*c2 - a[7]*c1) * invDet;
+    b[5] = ( a[0]*c5 - a[2]*c2 + a[3]*c1) * invDet;
+    b[6] = (-a[12]*s5 + a[14]*s2 - a[15]*s1) * invDet;
+    b[7] = ( a[8]*s5 - a[10]*s2 + a[11]*s1) * invDet;
+    b[8] = ( a[4]*c4 - a[5]*c2 + a[7]*c0) * invDet;
+    b[9] = (-a[0]*c4 + a[1]*c2 - a[3]*c0) * invDet;
+    b[10] = ( a[12]*s4 - a[13]*s2 + a[15]*s0) * invDet;
+    b[11] = (-a[8]*s4 + a[9]*s2 - a[11]*s0) * invDet;
+    b[12] = (-a[4]*c3 + a[5]*c1 - a[6]*c0) * invDet;
+    b[13] = ( a[0]*c3 - a[1]*c1 + a[2]*c0) * invDet;
+    b[14] = (-a[12]*s3 + a[13]*s1 - a[14]*s0) * invDet;
+    b[15] = ( a[8]*s3 - a[9]*s1 + a[10]*s0) * invDet;
+    return result;
+}
+
+static float maxDifference(const std::vector<Mat4>& a, const std::vector<Mat4>& b)
+{
+    float difference = 0.0f;
+    for (size_t i = 0; i < a.size(); i++) {
+        for (int k = 0; k < 16; k++) difference = std::max(difference, std::abs(a[i].m[k] - b[i].m[k]));
+    }
+    return difference;
+}
+
+// Best of "runs" timings of fn over the batch, in nanoseconds per element
+template <typename Fn>
+static double timePerElement(int count, int runs, Fn fn)
+{
+    double best = 1e30;
+    for (int r = 0; r < runs; r++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, seconds);
+    }
+    return best * 1e9 / count;
+}
+
+static void printTiming(const char* name, double kernel, double scalar, float difference)
+{
+    std::cout << name << kernel << " ns vs " << scalar << " ns scalar (" << scalar / kernel
+              << "x), largest difference " << difference << std::endl;
+}
+
+void benchmarkMath(int count, int runs)
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> coordinate(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> angle(-3.14159f, 3.14159f);
+    std::uniform_real_distribution<float> extent(0.2f, 3.0f);
+
+    std::vector<Vec3> positions(count), sizes(count);
+    std::vector<float> yaws(count);
+    for (int i = 0; i < count; i++) {
+        positions[i] = Vec3(coordinate(rng), coordinate(rng), coordinate(rng));
+        sizes[i] = Vec3(extent(rng), extent(rng), extent(rng));
+        yaws[i] = angle(rng);
+    }
+    Mat4 parent = Mat4::translate(Vec3(0.0f, 12.0f, 0.0f)) * Mat4::rotateX(0.3f) * Mat4::scale(Vec3(1.5f, 1.5f, 1.5f));
+
+    std::vector<Mat4> locals(count), kernel(count), scalar(count);
+    std::cout << count << " matrices, best of " << runs << " runs, per matrix:" << std::endl;
+
+    double placeTime = timePerElement(count, runs, [&]() {
+        placeTransforms(positions.data(), yaws.data(), sizes.data(), locals.data(), count);
+    });
+    double chainTime = timePerElement(count, runs, [&]() {
+        for (int i = 0; i < count; i++) {
+            scalar[i] = multiplyScalar(multiplyScalar(Mat4::translate(positions[i]), Mat4::rotateY(yaws[i])),
+                                       Mat4::scale(sizes[i]));
+        }
+    });
+    printTiming("Placement:       ", placeTime, chainTime, maxDifference(locals, scalar));
+
+    double productTime = timePerElement(count, runs, [&]() {
+        for (int i = 0; i < count; i++) kernel[i] = parent * locals[i];
+    });
+    double scalarTime = timePerElement(count, runs, [&]() {
+        for (int i = 0; i < count; i++) scalar[i] = multiplyScalar(parent, locals[i]);
+    });
+    printTiming("Mat4 product:    ", productTime, scalarTime, maxDifference(kernel, scalar));
+
+    double composeTime = timePerElement(count, runs, [&]() {
+        composeTransforms(parent, locals.data(), kernel.data(), count);
+    });
+    printTiming("Batch compose:   ", composeTime, scalarTime, maxDifference(kernel, scalar));
+
+    double affineTime = timePerElement(count, runs, [&]() {
+        for (int i = 0; i < count; i++) kernel[i] = affineInverse(locals[i]);
+    });
+    double generalTime = timePerElement(count, runs, [&]() {
+        for (int i = 0; i < count; i++) scalar[i] = generalInverse(locals[i]);
+    });
+    printTiming("Affine inverse:  ", affineTime, generalTime, maxDifference(kernel, scalar));
+
+    double normalTime = timePerElement(count, runs, [&]() {
+        for (int i = 0; i < count; i++) kernel[i] = normalMatrix(locals[i]);
+    });
+    // The full inverse transposed, with its translation row dropped the way mat3() does
+    for (int i = 0; i < count; i++) {
+        Mat4 transposed;
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) transposed.m[r + c*4] = scalar[i].m[c + r*4];
+        }
+        scalar[i] = transposed;
+    }
+    printTiming("Normal matrix:   ", normalTime, generalTime, maxDifference(kernel, scalar));
+
+    std::vector<Vec3> unit(count), unitScalar(count);
+    double normalizeTime = timePerElement(count, runs, [&]() {
+        for (int i = 0; i < count; i++) unit[i] = positions[i].normalize();
+    });
+    double divideTime = timePerElement(count, runs, [&]() {
+        for (int i = 0; i < count; i++) unitScalar[i] = normalizeScalar(positions[i]);
+    });
+    float unitDifference = 0.0f;
+    for (int i = 0; i < count; i++) unitDifference = std::max(unitDifference, (unit[i] - unitScalar[i]).length());
+    printTiming("Vec3 normalize:  ", normalizeTime, divideTime, unitDifference);
+}
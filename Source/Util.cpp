@@ -1,5 +1,7 @@
 #define _CRT_SECURE_NO_WARNINGS
 #include "../Header/Util.h"
+#include "../Header/Shader.h"
+#include "../Header/GLState.h"
 
 #include <fstream>
 #include <sstream>
@@ -172,8 +174,8 @@ void setTextureFiltering(unsigned int texture) {
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void renderQuad(unsigned int VAO, unsigned int texture, unsigned int shader, float x, float y, float width, float height, float alpha) {
-    glUseProgram(shader);
+void renderQuad(unsigned int VAO, unsigned int texture, const ShaderProgram& shader, float x, float y, float width, float height, float alpha) {
+    useProgram(shader.id);
     
     float model[16] = {
         width, 0.0f, 0.0f, 0.0f,
@@ -182,22 +184,17 @@ void renderQuad(unsigned int VAO, unsigned int texture, unsigned int shader, flo
         x, y, 0.0f, 1.0f
     };
     
-    unsigned int uModelLoc = glGetUniformLocation(shader, "uModel");
-    glUniformMatrix4fv(uModelLoc, 1, GL_FALSE, model);
+    glUniformMatrix4fv(uniformLocation(shader, U_MODEL), 1, GL_FALSE, model);
+    setShaderFloat(shader, U_ALPHA, alpha);
     
-    unsigned int uAlphaLoc = glGetUniformLocation(shader, "uAlpha");
-    glUniform1f(uAlphaLoc, alpha);
+    bindTexture2D(0, texture);
     
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    
-    glBindVertexArray(VAO);
+    bindVertexArray(VAO);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
 }
 
-void renderColorQuad(unsigned int VAO, unsigned int shader, float x, float y, float width, float height, float r, float g, float b, float a) {
-    glUseProgram(shader);
+void renderColorQuad(unsigned int VAO, const ShaderProgram& shader, float x, float y, float width, float height, float r, float g, float b, float a) {
+    useProgram(shader.id);
     
     float model[16] = {
         width, 0.0f, 0.0f, 0.0f,
@@ -206,30 +203,14 @@ void renderColorQuad(unsigned int VAO, unsigned int shader, float x, float y, fl
         x, y, 0.0f, 1.0f
     };
     
-    unsigned int uModelLoc = glGetUniformLocation(shader, "uModel");
-    glUniformMatrix4fv(uModelLoc, 1, GL_FALSE, model);
-    
-    unsigned int uColorLoc = glGetUniformLocation(shader, "uColor");
-    glUniform4f(uColorLoc, r, g, b, a);
+    glUniformMatrix4fv(uniformLocation(shader, U_MODEL), 1, GL_FALSE, model);
+    setShaderVec4(shader, U_COLOR, r, g, b, a);
     
-    glBindVertexArray(VAO);
+    bindVertexArray(VAO);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
 }
 
 // 3D Helper Functions
-void setShaderMat4(unsigned int shader, const char* name, const Mat4& mat) {
-    glUniformMatrix4fv(glGetUniformLocation(shader, name), 1, GL_FALSE, mat.m);
-}
-
-void setShaderVec3(unsigned int shader, const char* name, const Vec3& vec) {
-    glUniform3f(glGetUniformLocation(shader, name), vec.x, vec.y, vec.z);
-}
-
-void setShaderFloat(unsigned int shader, const char* name, float value) {
-    glUniform1f(glGetUniformLocation(shader, name), value);
-}
-
 unsigned int create3DQuadVAO() {
     // 3D quad with positions, texture coords, and normals (facing +Y by default, floor)
     float vertices[] = {
@@ -369,40 +350,28 @@ unsigned int createCubeVAO() {
     return VAO;
 }
 
-void render3DQuad(unsigned int VAO, unsigned int texture, unsigned int shader, const Mat4& model, const Mat4& view, const Mat4& projection, const Vec3& lightPos, const Vec3& viewPos) {
-    glUseProgram(shader);
+void render3DQuad(unsigned int VAO, unsigned int texture, const ShaderProgram& shader, const Mat4& model) {
+    useProgram(shader.id);
     
-    setShaderMat4(shader, "uModel", model);
-    setShaderMat4(shader, "uView", view);
-    setShaderMat4(shader, "uProjection", projection);
-    setShaderVec3(shader, "uLightPos", lightPos);
-    setShaderVec3(shader, "uViewPos", viewPos);
-    setShaderVec3(shader, "uLightColor", Vec3(1.0f, 1.0f, 1.0f));
-    setShaderFloat(shader, "uAmbientStrength", 0.4f);
-    setShaderFloat(shader, "uAlpha", 1.0f);
+    setShaderMat4(shader, U_MODEL, model);
+    setShaderFloat(shader, U_AMBIENT_STRENGTH, 0.4f);
+    setShaderFloat(shader, U_ALPHA, 1.0f);
     
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    bindTexture2D(0, texture);
     
-    glBindVertexArray(VAO);
+    bindVertexArray(VAO);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
 }
 
-void render3DColorQuad(unsigned int VAO, unsigned int shader, const Mat4& model, const Mat4& view, const Mat4& projection, const Vec3& lightPos, float r, float g, float b, float a) {
-    glUseProgram(shader);
+void render3DColorQuad(unsigned int VAO, const ShaderProgram& shader, const Mat4& model, float r, float g, float b, float a) {
+    useProgram(shader.id);
     
-    setShaderMat4(shader, "uModel", model);
-    setShaderMat4(shader, "uView", view);
-    setShaderMat4(shader, "uProjection", projection);
-    setShaderVec3(shader, "uLightPos", lightPos);
-    setShaderVec3(shader, "uLightColor", Vec3(1.0f, 1.0f, 1.0f));
-    setShaderFloat(shader, "uAmbientStrength", 0.4f);
-    glUniform4f(glGetUniformLocation(shader, "uColor"), r, g, b, a);
+    setShaderMat4(shader, U_MODEL, model);
+    setShaderFloat(shader, U_AMBIENT_STRENGTH, 0.4f);
+    setShaderVec4(shader, U_COLOR, r, g, b, a);
     
-    glBindVertexArray(VAO);
+    bindVertexArray(VAO);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
 }
 
 OBJModel loadOBJModel(const char* objPath, const char* texturePath) {
@@ -552,29 +521,19 @@ OBJModel loadOBJModel(const char* objPath, const char* texturePath) {
     return model;
 }
 
-void renderOBJModel(const OBJModel& model, unsigned int shader, const Mat4& modelMatrix, const Mat4& view, const Mat4& projection, const Vec3& lightPos, const Vec3& viewPos) {
+void renderOBJModel(const OBJModel& model, const ShaderProgram& shader, const Mat4& modelMatrix) {
     if (model.VAO == 0) return;
 
-    glUseProgram(shader);
+    // Camera and light come from the bound Frame and Light blocks
+    useProgram(shader.id);
     
-    setShaderMat4(shader, "uModel", modelMatrix);
-    setShaderMat4(shader, "uView", view);
-    setShaderMat4(shader, "uProjection", projection);
-    setShaderVec3(shader, "uLightPos", lightPos);
-    setShaderVec3(shader, "uViewPos", viewPos);
-    setShaderVec3(shader, "uLightColor", Vec3(1.0f, 0.95f, 0.9f));  // Warm white light
-    setShaderFloat(shader, "uAmbientStrength", 0.25f);  // Moderate ambient
-    setShaderFloat(shader, "uConstant", 1.0f);
-    setShaderFloat(shader, "uLinear", 0.14f);
-    setShaderFloat(shader, "uQuadratic", 0.07f);
-    setShaderFloat(shader, "uAlpha", 1.0f);
+    setShaderMat4(shader, U_MODEL, modelMatrix);
+    setShaderFloat(shader, U_AMBIENT_STRENGTH, 0.25f);  // Moderate ambient
     
     if (model.texture > 0) {
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, model.texture);
+        bindTexture2D(0, model.texture);
     }
     
-    glBindVertexArray(model.VAO);
+    bindVertexArray(model.VAO);
     glDrawArrays(GL_TRIANGLES, 0, model.vertexCount);
-    glBindVertexArray(0);
 }